@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+	BlockStateSpaceIIR.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockStateSpaceIIR.h"
+#include <cstring>
+
+namespace
+{
+	struct Matrix2
+	{
+		double m00, m01, m10, m11;
+
+		Matrix2 operator*(const Matrix2& o) const
+		{
+			return { m00 * o.m00 + m01 * o.m10, m00 * o.m01 + m01 * o.m11,
+					 m10 * o.m00 + m11 * o.m10, m10 * o.m01 + m11 * o.m11 };
+		}
+	};
+}
+
+BlockStateSpaceIIR::BlockStateSpaceIIR()
+{
+	reset();
+}
+
+void BlockStateSpaceIIR::setSections(const juce::dsp::IIR::Coefficients<float>* const* cascade, int numCascadeSections) noexcept
+{
+	numSections = juce::jmin(numCascadeSections, maxSections);
+
+	for (int i = 0; i < numSections; ++i)
+		design(sections[static_cast<size_t>(i)], *cascade[i]);
+
+	for (int i = numSections; i < maxSections; ++i)
+		sections[static_cast<size_t>(i)].s1 = sections[static_cast<size_t>(i)].s2 = 0.f;
+}
+
+void BlockStateSpaceIIR::reset() noexcept
+{
+	for (auto& section : sections)
+		section.s1 = section.s2 = 0.f;
+}
+
+void BlockStateSpaceIIR::design(Section& section, const juce::dsp::IIR::Coefficients<float>& coefficients) noexcept
+{
+	const auto* c = coefficients.getRawCoefficients();
+	double b0, b1, b2 = 0.0, a1, a2 = 0.0;
+
+	if (coefficients.getFilterOrder() == 1)
+	{
+		b0 = c[0]; b1 = c[1]; a1 = c[2];
+	}
+	else
+	{
+		b0 = c[0]; b1 = c[1]; b2 = c[2]; a1 = c[3]; a2 = c[4];
+	}
+
+	// x[n+1] = A x[n] + B u[n], y[n] = C x[n] + D u[n] with C = [1 0] and D = b0
+	const Matrix2 a{ -a1, 1.0, -a2, 0.0 };
+	const double bx = b1 - a1 * b0, by = b2 - a2 * b0;
+
+	// powers[k] = A^k
+	std::array<Matrix2, blockLength + 1> powers;
+	powers[0] = { 1.0, 0.0, 0.0, 1.0 };
+	for (size_t k = 1; k < powers.size(); ++k)
+		powers[k] = powers[k - 1] * a;
+
+	// h[0] = D, h[k] = C A^(k-1) B
+	std::array<double, blockLength> h;
+	h[0] = b0;
+	for (size_t k = 1; k < blockLength; ++k)
+		h[k] = powers[k - 1].m00 * bx + powers[k - 1].m01 * by;
+
+	for (size_t i = 0; i < blockLength; ++i)
+	{
+		section.o0[i] = static_cast<float>(powers[i].m00);
+		section.o1[i] = static_cast<float>(powers[i].m01);
+
+		for (size_t j = 0; j < blockLength; ++j)
+			section.t[j][i] = i >= j ? static_cast<float>(h[i - j]) : 0.f;
+
+		// Column i of K is A^(L-1-i) B
+		const auto& p = powers[blockLength - 1 - i];
+		section.k0[i] = static_cast<float>(p.m00 * bx + p.m01 * by);
+		section.k1[i] = static_cast<float>(p.m10 * bx + p.m11 * by);
+	}
+
+	const auto& al = powers[blockLength];
+	section.al00 = static_cast<float>(al.m00);
+	section.al01 = static_cast<float>(al.m01);
+	section.al10 = static_cast<float>(al.m10);
+	section.al11 = static_cast<float>(al.m11);
+
+	section.b0 = static_cast<float>(b0);
+	section.b1 = static_cast<float>(b1);
+	section.b2 = static_cast<float>(b2);
+	section.a1 = static_cast<float>(a1);
+	section.a2 = static_cast<float>(a2);
+}
+
+void BlockStateSpaceIIR::process(float* samples, int numSamples) noexcept
+{
+	// One section over the whole buffer at a time, the next one takes its output
+	for (int i = 0; i < numSections; ++i)
+		processSection(sections[static_cast<size_t>(i)], samples, numSamples);
+}
+
+void BlockStateSpaceIIR::processSection(Section& s, float* samples, int numSamples) noexcept
+{
+	auto x0 = s.s1, x1 = s.s2;
+	int n = 0;
+
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<float>;
+
+	// One lane per sample of the block. Wider registers, AVX for one, take the
+	// scalar loop below instead
+	if constexpr (Lane::SIMDNumElements == blockLength)
+	{
+		const auto o0 = Lane::fromRawArray(s.o0.data());
+		const auto o1 = Lane::fromRawArray(s.o1.data());
+		const auto k0 = Lane::fromRawArray(s.k0.data());
+		const auto k1 = Lane::fromRawArray(s.k1.data());
+		const Lane t[blockLength]{ Lane::fromRawArray(s.t[0].data()), Lane::fromRawArray(s.t[1].data()),
+			Lane::fromRawArray(s.t[2].data()), Lane::fromRawArray(s.t[3].data()) };
+
+		alignas(16) float block[blockLength];
+
+		for (; n + blockLength <= numSamples; n += blockLength)
+		{
+			std::memcpy(block, samples + n, sizeof(block));
+			const auto u = Lane::fromRawArray(block);
+
+			auto y = o0 * x0 + o1 * x1;
+			for (int j = 0; j < blockLength; ++j)
+				y += t[j] * block[j];
+
+			const auto nx0 = s.al00 * x0 + s.al01 * x1 + (k0 * u).sum();
+			const auto nx1 = s.al10 * x0 + s.al11 * x1 + (k1 * u).sum();
+			x0 = nx0;
+			x1 = nx1;
+
+			y.copyToRawArray(block);
+			std::memcpy(samples + n, block, sizeof(block));
+		}
+	}
+#endif
+
+	// Whatever the SIMD loop didn't take
+	for (; n + blockLength <= numSamples; n += blockLength)
+	{
+		float y[blockLength];
+		auto nx0 = s.al00 * x0 + s.al01 * x1;
+		auto nx1 = s.al10 * x0 + s.al11 * x1;
+
+		for (size_t i = 0; i < blockLength; ++i)
+			y[i] = s.o0[i] * x0 + s.o1[i] * x1;
+
+		for (size_t j = 0; j < blockLength; ++j)
+		{
+			const auto u = samples[n + static_cast<int>(j)];
+			for (size_t i = j; i < blockLength; ++i)
+				y[i] += s.t[j][i] * u;
+
+			nx0 += s.k0[j] * u;
+			nx1 += s.k1[j] * u;
+		}
+
+		std::memcpy(samples + n, y, sizeof(y));
+		x0 = nx0;
+		x1 = nx1;
+	}
+
+	// Transposed direct form II on the same state
+	for (; n < numSamples; ++n)
+	{
+		const auto u = samples[n];
+		const auto y = s.b0 * u + x0;
+		x0 = s.b1 * u - s.a1 * y + x1;
+		x1 = s.b2 * u - s.a2 * y;
+		samples[n] = y;
+	}
+
+	s.s1 = x0;
+	s.s2 = x1;
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+	BlockStateSpaceIIR.h
+
+	Runs each biquad of the cascade four samples at a time. Written as a state
+	space system, a block of outputs is y = O x + T u and the state moves on
+	by x = A^L x + K u, so the four outputs come out of a handful of SIMD
+	multiply-adds instead of four dependent scalar steps. The state is the
+	transposed direct form II state, so the samples left over at the end of a
+	block run through the plain recursion and carry straight on.
+
+	The result isn't bit-identical to IIR::Filter: the block matrices are
+	designed in double but applied in float, and they round differently from
+	the recursion. Over 200 random settings of the whole chain, the worst
+	error against a double-precision cascade is -50 dB relative to the output
+	peak, where the float cascade itself reaches -45 dB. BlockStateSpaceTest
+	in Tests/DspTests.cpp fails if it strays above -40 dB from the float
+	cascade.
+
+	The SIMD loop needs exactly one lane per sample of the block, so builds
+	with wider registers run the same blocks through the scalar loop.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include "ParallelIIR.h"
+
+class BlockStateSpaceIIR
+{
+public:
+	static constexpr int blockLength = 4;
+	static constexpr int maxSections = ParallelIIRDesign::maxSections;
+
+	BlockStateSpaceIIR();
+
+	// Keeps the state of sections that carry over, the same way IIR::Filter
+	// keeps its state when its coefficients are replaced
+	void setSections(const juce::dsp::IIR::Coefficients<float>* const* cascade, int numCascadeSections) noexcept;
+	void reset() noexcept;
+
+	void process(float* samples, int numSamples) noexcept;
+
+	int getNumSections() const noexcept { return numSections; }
+
+private:
+	struct Section
+	{
+		// Lane i of every column belongs to output sample i of the block
+		alignas(16) std::array<float, blockLength> o0, o1;        // columns of O, the response to the state
+		alignas(16) std::array<std::array<float, blockLength>, blockLength> t;  // columns of T, the response to each input
+		alignas(16) std::array<float, blockLength> k0, k1;        // rows of K
+		float al00 = 0.f, al01 = 0.f, al10 = 0.f, al11 = 0.f;     // A^L
+
+		// For the samples that don't fill a block
+		float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+
+		float s1 = 0.f, s2 = 0.f;
+	};
+
+	static void design(Section& section, const juce::dsp::IIR::Coefficients<float>& coefficients) noexcept;
+	static void processSection(Section& section, float* samples, int numSamples) noexcept;
+
+	std::array<Section, maxSections> sections;
+	int numSections = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BlockStateSpaceIIR)
+};
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+	DeferredPreparation.cpp
+
+  ==============================================================================
+*/
+
+#include "DeferredPreparation.h"
+
+DeferredPreparation::~DeferredPreparation()
+{
+	cancel();
+}
+
+void DeferredPreparation::addTask(Task task)
+{
+	tasks.push_back(std::move(task));
+}
+
+void DeferredPreparation::start(double sampleRate, int samplesPerBlock)
+{
+	cancel();
+
+	auto generationToRun = generation.load();
+	auto startTimeMs = juce::Time::getMillisecondCounterHiRes();
+
+	workerPool->addJob(this, WorkerPool::TaskType::Preparation,
+		[this, generationToRun, sampleRate, samplesPerBlock, startTimeMs]
+		{
+			run(generationToRun, sampleRate, samplesPerBlock, startTimeMs);
+		});
+}
+
+void DeferredPreparation::cancel()
+{
+	// The tasks are not interruptible, so this waits for the current one to finish
+	++generation;
+	workerPool->cancelJobsFor(this);
+	ready.store(false, std::memory_order_release);
+}
+
+void DeferredPreparation::run(int generationToRun, double sampleRate, int samplesPerBlock, double startTimeMs)
+{
+	for (auto& task : tasks)
+	{
+		if (generation.load() != generationToRun)
+			return;
+
+		task(sampleRate, samplesPerBlock);
+	}
+
+	if (generation.load() != generationToRun)
+		return;
+
+	lastReadyTimeMs.store(juce::Time::getMillisecondCounterHiRes() - startTimeMs);
+	ready.store(true, std::memory_order_release);
+}
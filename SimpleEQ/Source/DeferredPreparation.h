@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+	DeferredPreparation.h
+
+	Builds the expensive parts of the processor (analyzer state, FFT plans and
+	anything else that is slow to set up) away from prepareToPlay, so session
+	load and sample-rate switches return quickly. The audio thread keeps running
+	the plain IIR chain until isReady() flips.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "WorkerPool.h"
+
+class DeferredPreparation
+{
+public:
+	using Task = std::function<void(double sampleRate, int samplesPerBlock)>;
+
+	DeferredPreparation() = default;
+	~DeferredPreparation();
+
+	// Tasks run in the order they were added, on every call to start()
+	void addTask(Task task);
+
+	// Cancels a build that is still in flight and starts a fresh one
+	void start(double sampleRate, int samplesPerBlock);
+	void cancel();
+
+	// Safe to call from the audio thread. Once true, everything the tasks built
+	// is visible to the caller.
+	bool isReady() const noexcept { return ready.load(std::memory_order_acquire); }
+
+	// Time from the last start() until the resources were ready
+	double getLastReadyTimeMs() const noexcept { return lastReadyTimeMs.load(); }
+
+private:
+	void run(int generationToRun, double sampleRate, int samplesPerBlock, double startTimeMs);
+
+	juce::SharedResourcePointer<WorkerPool> workerPool;
+	std::vector<Task> tasks;
+
+	std::atomic<int> generation{ 0 };
+	std::atomic<bool> ready{ false };
+	std::atomic<double> lastReadyTimeMs{ 0.0 };
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeferredPreparation)
+};
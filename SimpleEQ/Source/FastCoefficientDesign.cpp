@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+	FastCoefficientDesign.cpp
+
+  ==============================================================================
+*/
+
+#include "FastCoefficientDesign.h"
+
+void FastCoefficientDesign::designPeaks(PeakBatch& batch, double sampleRate) noexcept
+{
+	const auto twoPiOverRate = static_cast<float>(juce::MathConstants<double>::twoPi / sampleRate);
+
+	for (size_t i = 0; i < batchSize; ++i)
+	{
+		// Same as makePeakFilter: A = sqrt(gain) = 10^(dB / 40)
+		const auto a = exp2(batch.gainInDecibels[i] * 0.083048202372f);
+		const auto omega = juce::jmin(pi, twoPiOverRate * juce::jmax(batch.freq[i], 2.f));
+		const auto cosOmega = cos(omega);
+		const auto alpha = sin(omega) / (2.f * batch.quality[i]);
+
+		const auto alphaTimesA = alpha * a;
+		const auto alphaOverA = alpha / a;
+		const auto inverseA0 = 1.f / (1.f + alphaOverA);
+
+		batch.b0[i] = (1.f + alphaTimesA) * inverseA0;
+		batch.b1[i] = -2.f * cosOmega * inverseA0;
+		batch.b2[i] = (1.f - alphaTimesA) * inverseA0;
+		batch.a1[i] = batch.b1[i];
+		batch.a2[i] = (1.f - alphaOverA) * inverseA0;
+	}
+}
+
+void FastCoefficientDesign::copyToCoefficients(const PeakBatch& batch, int lane, juce::dsp::IIR::Coefficients<float>& coefficients) noexcept
+{
+	jassert(juce::isPositiveAndBelow(lane, batchSize));
+
+	// Only a set that isn't second order yet, like a fresh filter's, allocates
+	coefficients.coefficients.resize(5);
+
+	const auto i = static_cast<size_t>(lane);
+	auto* c = coefficients.getRawCoefficients();
+	c[0] = batch.b0[i];
+	c[1] = batch.b1[i];
+	c[2] = batch.b2[i];
+	c[3] = batch.a1[i];
+	c[4] = batch.a2[i];
+}
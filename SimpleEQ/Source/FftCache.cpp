@@ -0,0 +1,23 @@
+/*
+  ==============================================================================
+
+	FftCache.cpp
+
+  ==============================================================================
+*/
+
+#include "FftCache.h"
+
+const juce::dsp::FFT& FftCache::get(int order)
+{
+	jassert(order >= minOrder && order <= maxOrder);
+	order = juce::jlimit(minOrder, maxOrder, order);
+
+	const std::lock_guard<std::mutex> guard(lock);
+
+	auto& fft = ffts[static_cast<size_t>(order - minOrder)];
+	if (fft == nullptr)
+		fft = std::make_unique<juce::dsp::FFT>(order);
+
+	return *fft;
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+	FftCache.h
+
+	One juce::dsp::FFT per size for the whole process, shared by the spectrum
+	analyzers and the STFT pipelines of every SimpleEQ instance through a
+	SharedResourcePointer. The FFT engines keep their twiddle tables and plans
+	per size, so there's no reason for each user to build its own.
+
+	get() may create an engine, so call it while preparing, not from the audio
+	thread. The engines themselves are only read by perform(), which is safe to
+	call from several threads at once.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+#include <mutex>
+
+class FftCache
+{
+public:
+	static constexpr int minOrder = 8;
+	static constexpr int maxOrder = 13;
+
+	// Lives as long as the cache does
+	const juce::dsp::FFT& get(int order);
+
+private:
+	std::mutex lock;
+	std::array<std::unique_ptr<juce::dsp::FFT>, maxOrder - minOrder + 1> ffts;
+};
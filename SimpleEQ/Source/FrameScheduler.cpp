@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+	FrameScheduler.cpp
+
+  ==============================================================================
+*/
+
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler()
+{
+	startTimerHz(monitorRateHz);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	stopTimer();
+	vblank.reset();
+}
+
+void FrameScheduler::addProducer(Producer* producer)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	producers.push_back(producer);
+}
+
+void FrameScheduler::removeProducer(Producer* producer)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	producers.erase(std::remove(producers.begin(), producers.end(), producer), producers.end());
+}
+
+void FrameScheduler::addClient(Client* client)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	clients.push_back(client);
+}
+
+void FrameScheduler::removeClient(Client* client)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+
+	if (client == vblankClient)
+	{
+		vblank.reset();
+		vblankClient = nullptr;
+		attachToVisibleClient();
+	}
+}
+
+void FrameScheduler::addMonitor(Monitor* monitor)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	monitors.push_back(monitor);
+}
+
+void FrameScheduler::removeMonitor(Monitor* monitor)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+	monitors.erase(std::remove(monitors.begin(), monitors.end(), monitor), monitors.end());
+}
+
+bool FrameScheduler::isOnScreen(juce::Component& component)
+{
+	if (!component.isShowing())
+		return false;
+
+	auto* peer = component.getPeer();
+	if (peer == nullptr || peer->isMinimised())
+		return false;
+
+	// JUCE's peers don't report a window being covered by other windows, so a
+	// buried editor still counts. Within the window, a plot hidden behind an
+	// opaque sibling or clipped away by its parents doesn't, and neither does
+	// a window moved entirely off the displays.
+	juce::RectangleList<int> visibleArea;
+	component.getVisibleArea(visibleArea, true);
+	if (visibleArea.isEmpty())
+		return false;
+
+	const auto onScreen = component.localAreaToGlobal(visibleArea.getBounds());
+	return juce::Desktop::getInstance().getDisplays().getTotalBounds(false).intersects(onScreen);
+}
+
+void FrameScheduler::timerCallback()
+{
+	// Monitors may remove themselves while ticking, so walk a copy
+	auto toTick = monitors;
+	for (auto* monitor : toTick)
+		if (std::find(monitors.begin(), monitors.end(), monitor) != monitors.end())
+			monitor->monitorTick();
+
+	if (vblankClient == nullptr || !isOnScreen(vblankClient->getScheduledComponent()))
+	{
+		vblank.reset();
+		vblankClient = nullptr;
+		attachToVisibleClient();
+	}
+}
+
+void FrameScheduler::attachToVisibleClient()
+{
+	for (auto* client : clients)
+	{
+		auto& component = client->getScheduledComponent();
+		if (isOnScreen(component))
+		{
+			vblankClient = client;
+			vblank = std::make_unique<juce::VBlankAttachment>(&component, [this] { tick(); });
+			return;
+		}
+	}
+}
+
+void FrameScheduler::tick(bool includeOffscreen)
+{
+	const auto now = juce::Time::getMillisecondCounterHiRes() / 1000.0;
+
+	for (auto* producer : producers)
+		producer->produceFrame(now);
+
+	// Clients may remove themselves while ticking, so walk a copy
+	auto toTick = clients;
+	for (auto* client : toTick)
+	{
+		if (std::find(clients.begin(), clients.end(), client) == clients.end())
+			continue;
+
+		if (includeOffscreen || isOnScreen(client->getScheduledComponent()))
+			client->frameTick();
+	}
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+	FrameScheduler.h
+
+	A single display-refresh tick shared by every open SimpleEQ editor in the
+	process, instead of one timer per plot or processor. Each tick first lets
+	the producers (the analyzers) request new data, then gives every client
+	whose component is actually on screen a chance to invalidate itself.
+	Monitors are polled from the scheduler's own timer instead, whether or not
+	anything is on screen, for work that has to notice an editor closing.
+	Message thread only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class FrameScheduler : private juce::Timer
+{
+public:
+	class Producer
+	{
+	public:
+		virtual ~Producer() = default;
+		virtual void produceFrame(double nowSeconds) = 0;
+	};
+
+	class Client
+	{
+	public:
+		virtual ~Client() = default;
+		virtual juce::Component& getScheduledComponent() = 0;
+		virtual void frameTick() = 0;
+	};
+
+	class Monitor
+	{
+	public:
+		virtual ~Monitor() = default;
+		virtual void monitorTick() = 0;
+	};
+
+	// How often monitors are polled
+	static constexpr int monitorRateHz = 10;
+
+	FrameScheduler();
+	~FrameScheduler() override;
+
+	void addProducer(Producer* producer);
+	void removeProducer(Producer* producer);
+
+	void addClient(Client* client);
+	void removeClient(Client* client);
+
+	void addMonitor(Monitor* monitor);
+	void removeMonitor(Monitor* monitor);
+
+	// Showing, not minimised, and not fully covered within its own window.
+	// Other windows covering it go unnoticed.
+	static bool isOnScreen(juce::Component& component);
+
+	// Normally called by the vblank. Offscreen renders, which never get one,
+	// call it directly and include the clients that aren't on screen.
+	void tick(bool includeOffscreen = false);
+
+private:
+	// Polls the monitors and re-checks which component drives the vblank, in
+	// case it was hidden or minimised
+	void timerCallback() override;
+
+	void attachToVisibleClient();
+
+	std::vector<Producer*> producers;
+	std::vector<Client*> clients;
+	std::vector<Monitor*> monitors;
+
+	Client* vblankClient = nullptr;
+	std::unique_ptr<juce::VBlankAttachment> vblank;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FrameScheduler)
+};
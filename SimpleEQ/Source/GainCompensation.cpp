@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+	GainCompensation.cpp
+
+  ==============================================================================
+*/
+
+#include "GainCompensation.h"
+#include "LoudnessMeter.h"
+
+void GainCompensation::prepare(double newSampleRate)
+{
+	if (newSampleRate == sampleRate)
+		return;
+
+	sampleRate = newSampleRate;
+
+	// Log spaced points give every octave the same number of samples, which is pink
+	const auto top = maxFrequencyRatio * sampleRate;
+	frequencies.resize(static_cast<size_t>(numPoints));
+	for (int i = 0; i < numPoints; ++i)
+		frequencies[static_cast<size_t>(i)] = minFrequency * std::pow(top / minFrequency, i / (numPoints - 1.0));
+
+	std::vector<double> shelf(frequencies.size()), highPass(frequencies.size());
+	LoudnessMeter::makeShelf(sampleRate)->getMagnitudeForFrequencyArray(frequencies.data(), shelf.data(), frequencies.size(), sampleRate);
+	LoudnessMeter::makeHighPass(sampleRate)->getMagnitudeForFrequencyArray(frequencies.data(), highPass.data(), frequencies.size(), sampleRate);
+
+	weights.resize(frequencies.size());
+	totalWeight = 0.0;
+	for (size_t i = 0; i < weights.size(); ++i)
+	{
+		const auto k = shelf[i] * highPass[i];
+		weights[i] = k * k;
+		totalWeight += weights[i];
+	}
+}
+
+float GainCompensation::getLoudnessChangeDb(const juce::dsp::IIR::Coefficients<float>* const* sections, int numSections) const
+{
+	if (frequencies.empty() || numSections == 0)
+		return 0.f;
+
+	std::vector<double> power(frequencies.size(), 1.0), magnitude(frequencies.size());
+	for (int s = 0; s < numSections; ++s)
+	{
+		sections[s]->getMagnitudeForFrequencyArray(frequencies.data(), magnitude.data(), frequencies.size(), sampleRate);
+		for (size_t i = 0; i < power.size(); ++i)
+			power[i] *= magnitude[i] * magnitude[i];
+	}
+
+	auto weighted = 0.0;
+	for (size_t i = 0; i < power.size(); ++i)
+		weighted += weights[i] * power[i];
+
+	return static_cast<float>(10.0 * std::log10(juce::jmax(weighted / totalWeight, 1.0e-12)));
+}
+
+float GainCompensation::getCompensationDb(const juce::dsp::IIR::Coefficients<float>* const* sections, int numSections) const
+{
+	return juce::jlimit(-maxCompensationDb, maxCompensationDb, -getLoudnessChangeDb(sections, numSections));
+}
@@ -0,0 +1,54 @@
+/*
+  ==============================================================================
+
+	GainCompensation.h
+
+	Estimates how much louder or quieter a set of sections makes a typical
+	programme, from the magnitude response alone, so the output can be
+	levelled without measuring the signal.
+
+	The programme is taken to be pink noise, equal power per octave, and
+	loudness is K-weighted as in BS.1770. The response is evaluated on a
+	fixed grid of log-spaced frequencies, each weighted by the K-weighting
+	power there. The grid and weights are cached per sample rate, so an
+	estimate is one magnitude evaluation per section and a weighted sum.
+
+	prepare() from the message thread while no estimate is running, then
+	getLoudnessChangeDb() or getCompensationDb() from any thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+class GainCompensation
+{
+public:
+	// Against a dense reference over random settings this stays within 0.2 dB.
+	// The grid runs up to just below Nyquist, because the meter hears what a
+	// boost or cut does above 20 kHz too.
+	static constexpr int numPoints = 512;
+	static constexpr double minFrequency = 20.0;
+	static constexpr double maxFrequencyRatio = 0.49;
+
+	void prepare(double sampleRate);
+
+	// The change in K-weighted loudness of pink noise through the sections, in
+	// dB. Compensating means applying the negative of it.
+	float getLoudnessChangeDb(const juce::dsp::IIR::Coefficients<float>* const* sections, int numSections) const;
+
+	// The negated change, limited to the range of "Output Gain". A low cut
+	// above the high cut leaves next to nothing to level, and would otherwise
+	// ask for over 100 dB of gain.
+	static constexpr float maxCompensationDb = 24.f;
+	float getCompensationDb(const juce::dsp::IIR::Coefficients<float>* const* sections, int numSections) const;
+
+private:
+	double sampleRate = 0.0;
+	std::vector<double> frequencies;
+	std::vector<double> weights;
+	double totalWeight = 0.0;
+};
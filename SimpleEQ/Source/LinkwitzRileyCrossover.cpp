@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+	LinkwitzRileyCrossover.cpp
+
+  ==============================================================================
+*/
+
+#include "LinkwitzRileyCrossover.h"
+#include "PluginProcessor.h"
+
+LinkwitzRileyCrossover::LinkwitzRileyCrossover()
+{
+	for (auto& stage : stages)
+	{
+		for (auto* coefficients : { &stage.b0, &stage.b1, &stage.b2, &stage.na1, &stage.na2 })
+			for (auto& section : *coefficients)
+				section.fill(0.f);
+
+		stage.in.fill(0.f);
+		stage.out.fill(0.f);
+	}
+
+	reset();
+}
+
+void LinkwitzRileyCrossover::prepare(double newSampleRate, int maximumBlockSize)
+{
+	sampleRate = newSampleRate;
+	bands.setSize(maxBands, maximumBlockSize, false, true, false);
+	bands.clear();
+	reset();
+}
+
+void LinkwitzRileyCrossover::reset() noexcept
+{
+	for (auto& stage : stages)
+	{
+		for (auto& section : stage.s1)
+			section.fill(0.f);
+		for (auto& section : stage.s2)
+			section.fill(0.f);
+	}
+}
+
+void LinkwitzRileyCrossover::setCrossovers(const float* frequencies, int newNumBands, Order newOrder)
+{
+	newNumBands = juce::jlimit(1, maxBands, newNumBands);
+
+	// A different tree shares no state with the old one
+	if (newNumBands != numBands || newOrder != order)
+		reset();
+
+	numBands = newNumBands;
+	order = newOrder;
+
+	const auto slope = order == Order::LR4 ? Slope_12 : Slope_24;
+	numSections = order == Order::LR4 ? 2 : 4;
+
+	for (int c = 0; c < numBands - 1; ++c)
+	{
+		jassert(c == 0 || frequencies[c] >= frequencies[c - 1]);
+
+		auto lowPass = makeCutFilter(frequencies[c], sampleRate, slope, highCutButterworthMethod);
+		auto highPass = makeCutFilter(frequencies[c], sampleRate, slope, lowCutButterworthMethod);
+		const auto numButterworth = lowPass.size();
+
+		auto& stage = stages[static_cast<size_t>(c)];
+		stage.numLanes = (2 + c + laneWidth - 1) / laneWidth * laneWidth;
+
+		for (int s = 0; s < maxSections; ++s)
+		{
+			const auto section = static_cast<size_t>(s);
+			auto set = [&stage, section](int lane, float b0, float b1, float b2, float a1, float a2)
+			{
+				const auto l = static_cast<size_t>(lane);
+				stage.b0[section][l] = b0;
+				stage.b1[section][l] = b1;
+				stage.b2[section][l] = b2;
+				stage.na1[section][l] = -a1;
+				stage.na2[section][l] = -a2;
+			};
+
+			for (int lane = 0; lane < maxLanes; ++lane)
+				set(lane, 0.f, 0.f, 0.f, 0.f, 0.f);
+
+			if (s >= numSections)
+				continue;
+
+			// Both halves go through their Butterworth sections twice
+			const auto* lp = lowPass[s % numButterworth]->getRawCoefficients();
+			const auto* hp = highPass[s % numButterworth]->getRawCoefficients();
+			set(0, lp[0], lp[1], lp[2], lp[3], lp[4]);
+			set(1, hp[0], hp[1], hp[2], hp[3], hp[4]);
+
+			// The allpass shares the Butterworth poles, one section per Butterworth section
+			for (int band = 0; band < c; ++band)
+			{
+				if (s < numButterworth)
+					set(2 + band, lp[4], lp[3], 1.f, lp[3], lp[4]);
+				else
+					set(2 + band, 1.f, 0.f, 0.f, 0.f, 0.f);
+			}
+		}
+	}
+}
+
+void LinkwitzRileyCrossover::processStage(Stage& stage) noexcept
+{
+#if JUCE_USE_SIMD
+	for (int g = 0; g < stage.numLanes; g += laneWidth)
+	{
+		auto x = Lane::fromRawArray(stage.in.data() + g);
+
+		for (size_t s = 0; s < static_cast<size_t>(numSections); ++s)
+		{
+			auto state1 = Lane::fromRawArray(stage.s1[s].data() + g);
+			const auto state2 = Lane::fromRawArray(stage.s2[s].data() + g);
+
+			const auto y = Lane::fromRawArray(stage.b0[s].data() + g) * x + state1;
+			state1 = Lane::fromRawArray(stage.b1[s].data() + g) * x + Lane::fromRawArray(stage.na1[s].data() + g) * y + state2;
+			(Lane::fromRawArray(stage.b2[s].data() + g) * x + Lane::fromRawArray(stage.na2[s].data() + g) * y).copyToRawArray(stage.s2[s].data() + g);
+			state1.copyToRawArray(stage.s1[s].data() + g);
+			x = y;
+		}
+
+		x.copyToRawArray(stage.out.data() + g);
+	}
+#else
+	for (size_t lane = 0; lane < static_cast<size_t>(stage.numLanes); ++lane)
+	{
+		auto x = stage.in[lane];
+
+		for (size_t s = 0; s < static_cast<size_t>(numSections); ++s)
+		{
+			const auto y = stage.b0[s][lane] * x + stage.s1[s][lane];
+			stage.s1[s][lane] = stage.b1[s][lane] * x + stage.na1[s][lane] * y + stage.s2[s][lane];
+			stage.s2[s][lane] = stage.b2[s][lane] * x + stage.na2[s][lane] * y;
+			x = y;
+		}
+
+		stage.out[lane] = x;
+	}
+#endif
+}
+
+void LinkwitzRileyCrossover::process(const float* input, int numSamples) noexcept
+{
+	jassert(numSamples <= bands.getNumSamples());
+	numSamples = juce::jmin(numSamples, bands.getNumSamples());
+
+	std::array<float*, maxBands> outputs{};
+	for (int b = 0; b < numBands; ++b)
+		outputs[static_cast<size_t>(b)] = bands.getWritePointer(b);
+
+	const auto numCrossovers = numBands - 1;
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		std::array<float, maxBands> current{};
+		auto rest = input[i];
+
+		for (int c = 0; c < numCrossovers; ++c)
+		{
+			auto& stage = stages[static_cast<size_t>(c)];
+			stage.in[0] = rest;
+			stage.in[1] = rest;
+			for (int band = 0; band < c; ++band)
+				stage.in[static_cast<size_t>(2 + band)] = current[static_cast<size_t>(band)];
+
+			processStage(stage);
+
+			current[static_cast<size_t>(c)] = stage.out[0];
+			rest = stage.out[1];
+			for (int band = 0; band < c; ++band)
+				current[static_cast<size_t>(band)] = stage.out[static_cast<size_t>(2 + band)];
+		}
+
+		current[static_cast<size_t>(numCrossovers)] = rest;
+
+		for (size_t b = 0; b < static_cast<size_t>(numBands); ++b)
+			outputs[b][i] = current[b];
+	}
+}
+
+void LinkwitzRileyCrossover::sum(float* output, const float* gains, int numSamples) const noexcept
+{
+	juce::FloatVectorOperations::copyWithMultiply(output, bands.getReadPointer(0), gains[0], numSamples);
+	for (int b = 1; b < numBands; ++b)
+		juce::FloatVectorOperations::addWithMultiply(output, bands.getReadPointer(b), gains[b], numSamples);
+}
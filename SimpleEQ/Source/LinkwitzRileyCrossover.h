@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+	LinkwitzRileyCrossover.h
+
+	Splits one channel into up to five bands that sum back to an allpass of
+	the input. Each crossover is a Linkwitz-Riley pair: the Butterworth low
+	and high pass from makeCutFilter, each run twice. Slope_12 gives LR4 and
+	Slope_24 gives LR8.
+
+	The crossovers form a tree. The lowest splits the input, and each one
+	above it splits what the one below passed as high. A band that leaves the
+	tree early goes through the allpass of every later crossover, the sum of
+	that crossover's low and high pass, so all bands stay in phase with each
+	other. For Linkwitz-Riley that allpass is one section per Butterworth
+	section, with the same poles.
+
+	Every filter a crossover applies, both halves and the allpasses, reads
+	only what the crossover below produced. They run side by side as SIMD
+	lanes, one crossover after the next within each sample, so a sample
+	comes out of all five bands in one pass.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+class LinkwitzRileyCrossover
+{
+public:
+	enum class Order
+	{
+		LR4,
+		LR8
+	};
+
+	static constexpr int maxBands = 5;
+	static constexpr int maxCrossovers = maxBands - 1;
+
+	LinkwitzRileyCrossover();
+
+	void prepare(double sampleRate, int maximumBlockSize);
+	void reset() noexcept;
+
+	// frequencies holds numBands - 1 ascending crossover frequencies. Keeps the
+	// filter state when only the frequencies move.
+	void setCrossovers(const float* frequencies, int numBands, Order order);
+
+	// Fills the band buffers. numSamples mustn't exceed the prepared block size.
+	void process(const float* input, int numSamples) noexcept;
+
+	int getNumBands() const noexcept { return numBands; }
+
+	// Band 0 is the lowest. Valid for the samples of the last process call, and
+	// free to be changed in place before summing.
+	float* getBand(int band) noexcept { return bands.getWritePointer(band); }
+	const float* getBand(int band) const noexcept { return bands.getReadPointer(band); }
+
+	// Adds up the bands of the last process call with a gain for each
+	void sum(float* output, const float* gains, int numSamples) const noexcept;
+
+private:
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<float>;
+	static constexpr int laneWidth = static_cast<int>(Lane::SIMDNumElements);
+#else
+	static constexpr int laneWidth = 1;
+#endif
+
+	// Low pass, high pass and an allpass for each band below, padded to whole registers
+	static constexpr int maxLanes = 8;
+	static_assert(maxLanes >= 2 + maxCrossovers - 1 && maxLanes % laneWidth == 0, "a crossover's filters must fit its lanes");
+
+	// LR8 is two Butterworth sections, each run twice
+	static constexpr int maxSections = 4;
+
+	// Transposed direct form II, feedback coefficients negated. Lane 0 is the
+	// low pass, lane 1 the high pass and lane 2 + j the allpass on band j.
+	struct Stage
+	{
+		alignas(32) std::array<std::array<float, maxLanes>, maxSections> b0, b1, b2, na1, na2, s1, s2;
+		alignas(32) std::array<float, maxLanes> in, out;
+		int numLanes = 0;
+	};
+
+	void processStage(Stage& stage) noexcept;
+
+	std::array<Stage, maxCrossovers> stages;
+	int numBands = 1;
+	int numSections = 0;
+	Order order = Order::LR4;
+	double sampleRate = 44100.0;
+	juce::AudioBuffer<float> bands;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LinkwitzRileyCrossover)
+};
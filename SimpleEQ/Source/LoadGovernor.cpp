@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+	LoadGovernor.cpp
+
+  ==============================================================================
+*/
+
+#include "LoadGovernor.h"
+
+void LoadGovernor::prepare(double sampleRate, int samplesPerBlock)
+{
+	loadMeasurer.reset(sampleRate, samplesPerBlock);
+
+	auto blocksPerSecond = sampleRate / juce::jmax(1, samplesPerBlock);
+	blocksToStepDown = juce::jmax(1, juce::roundToInt(blocksPerSecond * stepDownHoldSeconds));
+	blocksToStepUp = juce::jmax(1, juce::roundToInt(blocksPerSecond * stepUpHoldSeconds));
+
+	blocksAboveLimit = 0;
+	blocksBelowLimit = 0;
+	currentTier.store(0);
+}
+
+void LoadGovernor::setNonRealtime(bool isNonRealtime) noexcept
+{
+	nonRealtime.store(isNonRealtime);
+}
+
+void LoadGovernor::update() noexcept
+{
+	if (nonRealtime.load(std::memory_order_relaxed))
+	{
+		currentTier.store(0, std::memory_order_relaxed);
+		blocksAboveLimit = 0;
+		blocksBelowLimit = 0;
+		return;
+	}
+
+	auto load = loadMeasurer.getLoadAsProportion();
+	auto tier = currentTier.load(std::memory_order_relaxed);
+
+	blocksAboveLimit = load > stepDownLoad ? blocksAboveLimit + 1 : 0;
+	blocksBelowLimit = load < stepUpLoad ? blocksBelowLimit + 1 : 0;
+
+	if (blocksAboveLimit >= blocksToStepDown && tier < static_cast<int>(quality_tiers.size()) - 1)
+	{
+		currentTier.store(tier + 1, std::memory_order_relaxed);
+		blocksAboveLimit = 0;
+	}
+	else if (blocksBelowLimit >= blocksToStepUp && tier > 0)
+	{
+		currentTier.store(tier - 1, std::memory_order_relaxed);
+		blocksBelowLimit = 0;
+	}
+}
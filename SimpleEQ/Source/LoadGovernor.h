@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+	LoadGovernor.h
+
+	Watches how much of the block budget processBlock uses and steps through
+	quality tiers with hysteresis, so dense sessions shed analyzer resolution
+	and control-rate precision before they drop audio. Offline renders are
+	pinned to full quality so the EQ output never depends on machine load.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+struct QualityTier
+{
+	int analyzerFftOrder;       // FFT size of the spectrum analyzer
+	int analyzerFrameDivisor;   // feed the analyzer on every nth block only
+	int controlRateSamples;     // sub-block size for smoothed and modulated parameters
+};
+
+const std::array<QualityTier, 4> quality_tiers
+{ {
+	{ 12, 1, 16 },
+	{ 11, 2, 32 },
+	{ 10, 4, 64 },
+	{ 10, 8, 128 }
+} };
+
+class LoadGovernor
+{
+public:
+	void prepare(double sampleRate, int samplesPerBlock);
+
+	// While offline the tier is held at full quality
+	void setNonRealtime(bool isNonRealtime) noexcept;
+
+	// Call once at the start of every processBlock, before the ScopedTimer
+	void update() noexcept;
+
+	juce::AudioProcessLoadMeasurer& getLoadMeasurer() noexcept { return loadMeasurer; }
+
+	int getCurrentTier() const noexcept { return currentTier.load(std::memory_order_relaxed); }
+	const QualityTier& getCurrentQuality() const noexcept { return quality_tiers[static_cast<size_t>(getCurrentTier())]; }
+	double getLoad() const { return loadMeasurer.getLoadAsProportion(); }
+
+private:
+	juce::AudioProcessLoadMeasurer loadMeasurer;
+
+	std::atomic<int> currentTier{ 0 };
+	std::atomic<bool> nonRealtime{ false };
+
+	int blocksAboveLimit = 0;
+	int blocksBelowLimit = 0;
+	int blocksToStepDown = 1;
+	int blocksToStepUp = 1;
+
+	static constexpr double stepDownLoad = 0.7;
+	static constexpr double stepUpLoad = 0.35;
+	static constexpr double stepDownHoldSeconds = 0.25;
+	static constexpr double stepUpHoldSeconds = 3.0;
+};
@@ -0,0 +1,230 @@
+/*
+  ==============================================================================
+
+	LoudnessMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+#include <utility>
+
+namespace
+{
+	// The analogue prototypes behind the 48 kHz coefficients in BS.1770, so
+	// other sample rates get the same response
+	const double shelf_frequency = 1681.974450955533;
+	const double shelf_gain_db = 3.999843853973347;
+	const double shelf_quality = 0.7071752369554196;
+	const double high_pass_frequency = 38.13547087602444;
+	const double high_pass_quality = 0.5003270373238773;
+}
+
+juce::dsp::IIR::Coefficients<float>::Ptr LoudnessMeter::makeShelf(double sampleRate)
+{
+	const auto k = std::tan(juce::MathConstants<double>::pi * shelf_frequency / sampleRate);
+	const auto vh = std::pow(10.0, shelf_gain_db / 20.0);
+	const auto vb = std::pow(vh, 0.4996667741545416);
+	const auto a0 = 1.0 + k / shelf_quality + k * k;
+
+	return new juce::dsp::IIR::Coefficients<float>(
+		static_cast<float>((vh + vb * k / shelf_quality + k * k) / a0),
+		static_cast<float>(2.0 * (k * k - vh) / a0),
+		static_cast<float>((vh - vb * k / shelf_quality + k * k) / a0),
+		1.f,
+		static_cast<float>(2.0 * (k * k - 1.0) / a0),
+		static_cast<float>((1.0 - k / shelf_quality + k * k) / a0));
+}
+
+juce::dsp::IIR::Coefficients<float>::Ptr LoudnessMeter::makeHighPass(double sampleRate)
+{
+	const auto k = std::tan(juce::MathConstants<double>::pi * high_pass_frequency / sampleRate);
+	const auto a0 = 1.0 + k / high_pass_quality + k * k;
+
+	// The standard leaves the numerator unnormalised, 1, -2, 1
+	return new juce::dsp::IIR::Coefficients<float>(
+		1.f, -2.f, 1.f,
+		1.f,
+		static_cast<float>(2.0 * (k * k - 1.0) / a0),
+		static_cast<float>((1.0 - k / high_pass_quality + k * k) / a0));
+}
+
+float LoudnessMeter::powerToLoudness(double power) noexcept
+{
+	return power > 0.0 ? static_cast<float>(-0.691 + 10.0 * std::log10(power)) : silence;
+}
+
+void LoudnessMeter::prepare(double sampleRate)
+{
+	const auto shelfCoefficients = makeShelf(sampleRate);
+	const auto highPassCoefficients = makeHighPass(sampleRate);
+
+#if JUCE_USE_SIMD
+	shelf.coefficients = shelfCoefficients;
+	highPass.coefficients = highPassCoefficients;
+#else
+	for (auto& filter : shelf)
+		filter.coefficients = shelfCoefficients;
+	for (auto& filter : highPass)
+		filter.coefficients = highPassCoefficients;
+#endif
+
+	subBlockLength = juce::roundToInt(sampleRate / 10.0);
+	binCounts.assign(static_cast<size_t>(numBins), 0);
+	binPowers.assign(static_cast<size_t>(numBins), 0.0);
+
+	reset();
+}
+
+void LoudnessMeter::reset() noexcept
+{
+#if JUCE_USE_SIMD
+	shelf.reset();
+	highPass.reset();
+	energy = Lane::expand(0.f);
+#else
+	for (auto& filter : shelf)
+		filter.reset();
+	for (auto& filter : highPass)
+		filter.reset();
+	energy.fill(0.f);
+#endif
+
+	subBlockPosition = 0;
+	history.fill(0.0);
+	historyIndex = 0;
+	blocksSeen = 0;
+	momentarySum = shortTermSum = 0.0;
+
+	std::fill(binCounts.begin(), binCounts.end(), 0u);
+	std::fill(binPowers.begin(), binPowers.end(), 0.0);
+	gatedCount = 0;
+	gatedPower = 0.0;
+
+	momentary.store(silence);
+	shortTerm.store(silence);
+	integrated.store(silence);
+}
+
+void LoudnessMeter::process(const juce::AudioBuffer<float>& buffer) noexcept
+{
+	const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+	const auto numSamples = buffer.getNumSamples();
+
+	std::array<const float*, maxChannels> channels{};
+	for (int ch = 0; ch < numChannels; ++ch)
+		channels[static_cast<size_t>(ch)] = buffer.getReadPointer(ch);
+
+#if JUCE_USE_SIMD
+	// Lanes without a channel filter silence
+	alignas(Lane::SIMDRegisterSize) float lanes[laneWidth]{};
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		for (int ch = 0; ch < numChannels; ++ch)
+			lanes[ch] = channels[static_cast<size_t>(ch)][i];
+
+		const auto weighted = highPass.processSample(shelf.processSample(Lane::fromRawArray(lanes)));
+		energy += weighted * weighted;
+
+		if (++subBlockPosition == subBlockLength)
+			finishSubBlock();
+	}
+#else
+	for (int i = 0; i < numSamples; ++i)
+	{
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			const auto index = static_cast<size_t>(ch);
+			const auto weighted = highPass[index].processSample(shelf[index].processSample(channels[index][i]));
+			energy[index] += weighted * weighted;
+		}
+
+		if (++subBlockPosition == subBlockLength)
+			finishSubBlock();
+	}
+#endif
+}
+
+void LoudnessMeter::finishSubBlock() noexcept
+{
+	// Every channel weighs 1 in stereo
+#if JUCE_USE_SIMD
+	const auto sum = static_cast<double>(energy.sum());
+	energy = Lane::expand(0.f);
+	shelf.snapToZero();
+	highPass.snapToZero();
+#else
+	double sum = 0.0;
+	for (auto& channel : energy)
+		sum += std::exchange(channel, 0.f);
+	for (auto& filter : shelf)
+		filter.snapToZero();
+	for (auto& filter : highPass)
+		filter.snapToZero();
+#endif
+
+	const auto power = sum / subBlockLength;
+	subBlockPosition = 0;
+
+	// Slide both windows on by one sub-block
+	const auto leaving = static_cast<size_t>((historyIndex + shortTermBlocks - momentaryBlocks) % shortTermBlocks);
+	momentarySum += power - history[leaving];
+	shortTermSum += power - history[static_cast<size_t>(historyIndex)];
+	history[static_cast<size_t>(historyIndex)] = power;
+	historyIndex = (historyIndex + 1) % shortTermBlocks;
+
+	// Once per lap, start the sums again from the powers so rounding can't build up
+	if (historyIndex == 0)
+	{
+		shortTermSum = 0.0;
+		for (auto p : history)
+			shortTermSum += p;
+
+		momentarySum = 0.0;
+		for (int b = shortTermBlocks - momentaryBlocks; b < shortTermBlocks; ++b)
+			momentarySum += history[static_cast<size_t>(b)];
+	}
+
+	blocksSeen = juce::jmin(blocksSeen + 1, shortTermBlocks);
+
+	// Until the windows fill up the missing sub-blocks count as silence
+	momentary.store(powerToLoudness(momentarySum / momentaryBlocks), std::memory_order_relaxed);
+	shortTerm.store(powerToLoudness(shortTermSum / shortTermBlocks), std::memory_order_relaxed);
+
+	if (blocksSeen >= momentaryBlocks)
+		addGatingBlock(momentarySum / momentaryBlocks);
+}
+
+void LoudnessMeter::addGatingBlock(double power) noexcept
+{
+	const auto loudness = powerToLoudness(power);
+	if (loudness <= absoluteGate)
+		return;
+
+	const auto bin = juce::jmin(numBins - 1, static_cast<int>((loudness - absoluteGate) * binsPerLU));
+	++binCounts[static_cast<size_t>(bin)];
+	binPowers[static_cast<size_t>(bin)] += power;
+	++gatedCount;
+	gatedPower += power;
+
+	// Only the blocks above the relative gate count towards the result
+	const auto threshold = powerToLoudness(gatedPower / static_cast<double>(gatedCount)) + relativeGate;
+	const auto first = juce::jlimit(0, numBins, static_cast<int>(std::ceil((threshold - absoluteGate) * binsPerLU)));
+
+	juce::int64 count = 0;
+	double sum = 0.0;
+	for (int b = first; b < numBins; ++b)
+	{
+		count += binCounts[static_cast<size_t>(b)];
+		sum += binPowers[static_cast<size_t>(b)];
+	}
+
+	integrated.store(count > 0 ? powerToLoudness(sum / static_cast<double>(count)) : silence, std::memory_order_relaxed);
+}
+
+juce::String LoudnessMeter::getReport() const
+{
+	return "momentary " + juce::String(getMomentary(), 1) + " LUFS, short-term " + juce::String(getShortTerm(), 1)
+		+ " LUFS, integrated " + juce::String(getIntegrated(), 1) + " LUFS";
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+	LoudnessMeter.h
+
+	ITU-R BS.1770 loudness of the output: momentary (400 ms), short-term
+	(3 s) and gated integrated loudness, in LUFS.
+
+	The K-weighting pre-filter is the standard's two sections, a high shelf
+	and the RLB high pass, run through IIR::Filter with the channels side by
+	side in one SIMD register, so stereo costs what mono does. The squared
+	output is summed over 100 ms sub-blocks. Momentary and short-term
+	loudness are sliding sums over the last 4 and 30 of them, each updated
+	with one addition and one subtraction.
+
+	Every momentary window is also a 400 ms gating block with 75% overlap.
+	Blocks above the absolute gate go into a histogram of 0.1 LU bins holding
+	a count and a power sum, so the relative gate and the integrated
+	loudness come from one pass over the bins rather than a list of every
+	block since the start. The relative gate is resolved to the bin.
+
+	process() is for the audio thread. The readings can be read from any
+	thread and are updated once per sub-block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <limits>
+#include <vector>
+
+class LoudnessMeter
+{
+public:
+	static constexpr int maxChannels = 2;
+	static constexpr float absoluteGate = -70.f;
+	static constexpr float relativeGate = -10.f;
+
+	// What the readings show before there is anything to measure
+	static constexpr float silence = -std::numeric_limits<float>::infinity();
+
+	void prepare(double sampleRate);
+
+	// Starts the integrated measurement again
+	void reset() noexcept;
+
+	void process(const juce::AudioBuffer<float>& buffer) noexcept;
+
+	float getMomentary() const noexcept { return momentary.load(std::memory_order_relaxed); }
+	float getShortTerm() const noexcept { return shortTerm.load(std::memory_order_relaxed); }
+	float getIntegrated() const noexcept { return integrated.load(std::memory_order_relaxed); }
+
+	juce::String getReport() const;
+
+	// The two K-weighting sections for any sample rate
+	static juce::dsp::IIR::Coefficients<float>::Ptr makeShelf(double sampleRate);
+	static juce::dsp::IIR::Coefficients<float>::Ptr makeHighPass(double sampleRate);
+
+	static float powerToLoudness(double power) noexcept;
+
+private:
+	void finishSubBlock() noexcept;
+	void addGatingBlock(double power) noexcept;
+
+	static constexpr int momentaryBlocks = 4;
+	static constexpr int shortTermBlocks = 30;
+	static constexpr int binsPerLU = 10;
+	static constexpr int numBins = 80 * binsPerLU;
+
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<float>;
+	static constexpr int laneWidth = static_cast<int>(Lane::SIMDNumElements);
+	static_assert(laneWidth >= maxChannels, "every channel needs a lane");
+
+	juce::dsp::IIR::Filter<Lane> shelf, highPass;
+	Lane energy{};
+#else
+	std::array<juce::dsp::IIR::Filter<float>, maxChannels> shelf, highPass;
+	std::array<float, maxChannels> energy{};
+#endif
+
+	int subBlockLength = 4800;
+	int subBlockPosition = 0;
+
+	// Sub-block powers, summed over channels
+	std::array<double, shortTermBlocks> history{};
+	int historyIndex = 0;
+	int blocksSeen = 0;
+	double momentarySum = 0.0;
+	double shortTermSum = 0.0;
+
+	// Gating blocks above the absolute gate
+	std::vector<juce::uint32> binCounts;
+	std::vector<double> binPowers;
+	juce::int64 gatedCount = 0;
+	double gatedPower = 0.0;
+
+	std::atomic<float> momentary{ silence };
+	std::atomic<float> shortTerm{ silence };
+	std::atomic<float> integrated{ silence };
+};
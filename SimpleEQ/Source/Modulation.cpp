@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+	Modulation.cpp
+
+  ==============================================================================
+*/
+
+#include "Modulation.h"
+#include "PluginProcessor.h"
+#include "FastCoefficientDesign.h"
+
+namespace
+{
+	const juce::StringArray source_names{ "None", "LFO 1", "LFO 2", "Envelope" };
+
+	// The envelope source reads the input level on a dB scale, 0 at this level and 1 at full scale
+	const float envelope_floor_db = -60.f;
+
+	juce::String getPrefix(int band) { return "Peak" + juce::String(band + 1); }
+}
+
+ModulationMatrix::ModulationMatrix(juce::AudioProcessorValueTreeState& apvts)
+{
+	for (int band = 0; band < numBands; ++band)
+	{
+		const auto prefix = getPrefix(band);
+		auto& f = freqDestinations[static_cast<size_t>(band)];
+		auto& g = gainDestinations[static_cast<size_t>(band)];
+
+		f.source = apvts.getRawParameterValue(prefix + " Freq Mod Source");
+		f.depth = apvts.getRawParameterValue(prefix + " Freq Mod Depth");
+		g.source = apvts.getRawParameterValue(prefix + " Gain Mod Source");
+		g.depth = apvts.getRawParameterValue(prefix + " Gain Mod Depth");
+	}
+
+	lfo1Rate = apvts.getRawParameterValue("LFO1 Rate");
+	lfo2Rate = apvts.getRawParameterValue("LFO2 Rate");
+	envelopeAttack = apvts.getRawParameterValue("Envelope Attack");
+	envelopeRelease = apvts.getRawParameterValue("Envelope Release");
+
+	freq.fill(1000.f);
+	gain.fill(0.f);
+	quality.fill(1.f);
+	reset();
+}
+
+void ModulationMatrix::addParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout)
+{
+	const auto depth_range = juce::NormalisableRange<float>(-1.f, 1.f, 0.01f);
+	const auto rate_range = juce::NormalisableRange<float>(0.01f, 20.f, 0.01f, 0.3f);
+	const auto time_range = juce::NormalisableRange<float>(1.f, 2000.f, 1.f, 0.4f);
+
+	for (int band = 0; band < numBands; ++band)
+	{
+		for (auto destination : { " Freq", " Gain" })
+		{
+			const auto name = getPrefix(band) + destination;
+
+			layout.add(std::make_unique<juce::AudioParameterChoice>(
+				name + " Mod Source", name + " Mod Source", source_names, None));
+			layout.add(std::make_unique<juce::AudioParameterFloat>(
+				name + " Mod Depth", name + " Mod Depth", depth_range, 0.f));
+		}
+	}
+
+	layout.add(std::make_unique<juce::AudioParameterFloat>("LFO1 Rate", "LFO1 Rate", rate_range, 0.5f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>("LFO2 Rate", "LFO2 Rate", rate_range, 2.f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>("Envelope Attack", "Envelope Attack", time_range, 10.f));
+	layout.add(std::make_unique<juce::AudioParameterFloat>("Envelope Release", "Envelope Release", time_range, 200.f));
+}
+
+void ModulationMatrix::prepare(double newSampleRate, int maximumBlockSize)
+{
+	sampleRate = newSampleRate;
+
+	// Enough for the shortest control block, one sample
+	inputPeaks.assign(static_cast<size_t>(juce::jmax(1, maximumBlockSize)), 0.f);
+	numInputPeaks = 0;
+
+	wetStep = static_cast<float>(1.0 / (handoverSeconds * sampleRate));
+	wet.fill(0.f);
+	reset();
+}
+
+void ModulationMatrix::reset() noexcept
+{
+	// The fades carry on, the chain's bands they are paired with don't reset theirs
+	lfo1Phase = lfo2Phase = 0.0;
+	lfo1 = lfo2 = 0.f;
+	envelopeLevel = envelope = 0.f;
+
+	for (auto& channel : ic1eq)
+		channel.fill(0.f);
+	for (auto& channel : ic2eq)
+		channel.fill(0.f);
+}
+
+int ModulationMatrix::getModulatedBands() const noexcept
+{
+	int bands = 0;
+	for (int band = 0; band < numBands; ++band)
+		if (freqDestinations[static_cast<size_t>(band)].isActive() || gainDestinations[static_cast<size_t>(band)].isActive())
+			bands |= 1 << band;
+
+	return bands;
+}
+
+void ModulationMatrix::followInput(const juce::AudioBuffer<float>& buffer, int modulatedBands, int controlRateSamples) noexcept
+{
+	numInputPeaks = 0;
+	if (modulatedBands == 0 || inputPeaks.empty())
+		return;
+
+	const auto numChannels = juce::jmin(2, buffer.getNumChannels());
+	const auto numSamples = buffer.getNumSamples();
+	const auto maxPeaks = static_cast<int>(inputPeaks.size());
+	controlRateSamples = juce::jmax(1, controlRateSamples);
+
+	for (int start = 0; start < numSamples; start += controlRateSamples)
+	{
+		const auto blockSize = juce::jmin(controlRateSamples, numSamples - start);
+
+		auto peak = 0.f;
+		for (int ch = 0; ch < numChannels; ++ch)
+			peak = juce::jmax(peak, buffer.getMagnitude(ch, start, blockSize));
+
+		// A host block longer than promised folds its tail into the last slot
+		if (numInputPeaks < maxPeaks)
+			inputPeaks[static_cast<size_t>(numInputPeaks++)] = peak;
+		else
+			inputPeaks.back() = juce::jmax(inputPeaks.back(), peak);
+	}
+}
+
+void ModulationMatrix::advanceSources(float inputPeak, int numSamples) noexcept
+{
+	const auto blockSeconds = numSamples / sampleRate;
+
+	auto advance = [blockSeconds](double& phase, float rate)
+	{
+		phase += rate * blockSeconds;
+		phase -= std::floor(phase);
+
+		// Phase in [0, 1) mapped onto [-pi, pi)
+		return FastCoefficientDesign::sin(static_cast<float>((phase - 0.5) * juce::MathConstants<double>::twoPi));
+	};
+
+	lfo1 = advance(lfo1Phase, lfo1Rate->load());
+	lfo2 = advance(lfo2Phase, lfo2Rate->load());
+
+	// One-pole follower stepped once per control block, e^-t computed as 2^(-t log2 e)
+	const auto timeMs = inputPeak > envelopeLevel ? envelopeAttack->load() : envelopeRelease->load();
+	const auto blocksPerTimeConstant = static_cast<float>(timeMs * 0.001 / blockSeconds);
+	const auto coefficient = 1.f - FastCoefficientDesign::exp2(-1.44269504f / blocksPerTimeConstant);
+	envelopeLevel += coefficient * (inputPeak - envelopeLevel);
+
+	const auto levelDb = juce::Decibels::gainToDecibels(envelopeLevel, envelope_floor_db);
+	envelope = juce::jlimit(0.f, 1.f, 1.f - levelDb / envelope_floor_db);
+}
+
+float ModulationMatrix::getSourceValue(const Destination& destination) const noexcept
+{
+	switch (static_cast<int>(destination.source->load()))
+	{
+		case Lfo1: return lfo1;
+		case Lfo2: return lfo2;
+		case Envelope: return envelope;
+		default: return 0.f;
+	}
+}
+
+void ModulationMatrix::design(const ChainSettings& settings) noexcept
+{
+	const std::array<float, numBands> baseFreq{ settings.peak1Freq, settings.peak2Freq, settings.peak3Freq, settings.peak4Freq, settings.peak5Freq };
+	const std::array<float, numBands> baseGain{ settings.peak1GainInDecibels, settings.peak2GainInDecibels, settings.peak3GainInDecibels,
+		settings.peak4GainInDecibels, settings.peak5GainInDecibels };
+	const std::array<float, numBands> baseQuality{ settings.peak1Quality, settings.peak2Quality, settings.peak3Quality,
+		settings.peak4Quality, settings.peak5Quality };
+
+	for (size_t band = 0; band < numBands; ++band)
+	{
+		const auto& f = freqDestinations[band];
+		const auto& g = gainDestinations[band];
+
+		const auto octaves = f.depth->load() * maxOctaves * getSourceValue(f);
+		freq[band] = baseFreq[band] * FastCoefficientDesign::exp2(octaves);
+		gain[band] = juce::jlimit(-maxDecibels, maxDecibels, baseGain[band] + g.depth->load() * maxDecibels * getSourceValue(g));
+		quality[band] = baseQuality[band];
+	}
+
+	// All lanes at once and without branches, so it vectorises like designPeaks
+	const auto piOverRate = static_cast<float>(juce::MathConstants<double>::pi / sampleRate);
+	const auto maxFreq = static_cast<float>(sampleRate * 0.49);
+
+	for (size_t i = 0; i < numLanes; ++i)
+	{
+		const auto a = FastCoefficientDesign::exp2(gain[i] * 0.083048202372f);
+		const auto g = FastCoefficientDesign::tan(piOverRate * juce::jlimit(2.f, maxFreq, freq[i]));
+		const auto k = 1.f / (quality[i] * a);
+
+		a1[i] = 1.f / (1.f + g * (g + k));
+		a2[i] = g * a1[i];
+		a3[i] = g * a2[i];
+		m1[i] = k * (a * a - 1.f);
+	}
+}
+
+void ModulationMatrix::process(juce::AudioBuffer<float>& buffer, const ChainSettings& settings, int modulatedBands, int controlRateSamples) noexcept
+{
+	std::array<int, numBands> bands;
+	int numActive = 0;
+	for (int band = 0; band < numBands; ++band)
+	{
+		const auto i = static_cast<size_t>(band);
+		const auto isModulated = (modulatedBands & (1 << band)) != 0;
+
+		// Bands joining the matrix start from silence, like the chain does for bands leaving it
+		if (isModulated && wet[i] == 0.f)
+			for (size_t ch = 0; ch < 2; ++ch)
+				ic1eq[ch][i] = ic2eq[ch][i] = 0.f;
+
+		if (isModulated || wet[i] > 0.f)
+			bands[static_cast<size_t>(numActive++)] = band;
+	}
+
+	if (numActive == 0)
+		return;
+
+	const auto numChannels = juce::jmin(2, buffer.getNumChannels());
+	const auto numSamples = buffer.getNumSamples();
+	controlRateSamples = juce::jmax(1, controlRateSamples);
+
+	for (int start = 0, controlBlock = 0; start < numSamples; start += controlRateSamples, ++controlBlock)
+	{
+		const auto blockSize = juce::jmin(controlRateSamples, numSamples - start);
+
+		// Silence if followInput didn't see this block
+		const auto inputPeak = numInputPeaks > 0 ? inputPeaks[static_cast<size_t>(juce::jmin(controlBlock, numInputPeaks - 1))] : 0.f;
+		advanceSources(inputPeak, blockSize);
+		design(settings);
+
+		// Each band's wet ramps per sample, the same way on both channels
+		std::array<float, numBands> wetStart, wetDelta;
+		for (int b = 0; b < numActive; ++b)
+		{
+			const auto band = bands[static_cast<size_t>(b)];
+			const auto i = static_cast<size_t>(band);
+			const auto target = (modulatedBands & (1 << band)) != 0 ? 1.f : 0.f;
+
+			wetStart[static_cast<size_t>(b)] = wet[i];
+			wetDelta[static_cast<size_t>(b)] = wet[i] < target ? wetStep : (wet[i] > target ? -wetStep : 0.f);
+			wet[i] = juce::jlimit(0.f, 1.f, wet[i] + wetDelta[static_cast<size_t>(b)] * static_cast<float>(blockSize));
+		}
+
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			auto* samples = buffer.getWritePointer(ch, start);
+			auto& s1 = ic1eq[static_cast<size_t>(ch)];
+			auto& s2 = ic2eq[static_cast<size_t>(ch)];
+
+			for (int n = 0; n < blockSize; ++n)
+			{
+				auto v0 = samples[n];
+
+				for (int b = 0; b < numActive; ++b)
+				{
+					const auto i = static_cast<size_t>(bands[static_cast<size_t>(b)]);
+					const auto v3 = v0 - s2[i];
+					const auto v1 = a1[i] * s1[i] + a2[i] * v3;
+					const auto v2 = s2[i] + a2[i] * s1[i] + a3[i] * v3;
+					s1[i] = 2.f * v1 - s1[i];
+					s2[i] = 2.f * v2 - s2[i];
+
+					// The bell is the input plus m1 v1, so a partly wet band scales that term
+					const auto w = juce::jlimit(0.f, 1.f, wetStart[static_cast<size_t>(b)] + wetDelta[static_cast<size_t>(b)] * static_cast<float>(n + 1));
+					v0 += w * m1[i] * v1;
+				}
+
+				samples[n] = v0;
+			}
+		}
+	}
+}
+
+void ModulationMatrix::skipFades(int modulatedBands, int bands) noexcept
+{
+	for (int band = 0; band < numBands; ++band)
+	{
+		if ((bands & (1 << band)) == 0)
+			continue;
+
+		const auto i = static_cast<size_t>(band);
+		const auto isModulated = (modulatedBands & (1 << band)) != 0;
+
+		if (isModulated && wet[i] == 0.f)
+			for (size_t ch = 0; ch < 2; ++ch)
+				ic1eq[ch][i] = ic2eq[ch][i] = 0.f;
+
+		wet[i] = isModulated ? 1.f : 0.f;
+	}
+}
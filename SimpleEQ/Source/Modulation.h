@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+	Modulation.h
+
+	Two LFOs and an envelope follower that can move the frequency and gain of
+	each peak without going through host automation. The envelope follows the
+	input before any filtering, so a band it moves doesn't feed back into its
+	own source. Sources are evaluated once per control block (the quality
+	tier's controlRateSamples) and all modulated bands are redesigned together
+	from one batch of fast trig.
+
+	A modulated band is taken out of the IIR chain and run here as a
+	topology-preserving state variable filter instead. Its bell has the same
+	response as makePeakFilter, but its state stays meaningful when the
+	coefficients jump every control block, so there's no zipper noise or
+	blow-up under fast modulation. A band joining or leaving the matrix fades
+	in or out over handoverSeconds while the chain fades its IIR band the
+	other way, so the SVF starting from zero state isn't heard. Bands nobody
+	modulates cost nothing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+struct ChainSettings;
+
+class ModulationMatrix
+{
+public:
+	enum Source
+	{
+		None = 0,
+		Lfo1,
+		Lfo2,
+		Envelope
+	};
+
+	static constexpr int numBands = 5;
+
+	// At full depth a source moves the frequency two octaves and the gain 24 dB either way
+	static constexpr float maxOctaves = 2.f;
+	static constexpr float maxDecibels = 24.f;
+
+	static constexpr int allBands = (1 << numBands) - 1;
+	static constexpr double handoverSeconds = 0.01;
+
+	explicit ModulationMatrix(juce::AudioProcessorValueTreeState& apvts);
+
+	static void addParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout);
+
+	void prepare(double sampleRate, int maximumBlockSize);
+	void reset() noexcept;
+
+	// One bit per band that has a source and a non-zero depth on frequency or gain
+	int getModulatedBands() const noexcept;
+
+	// Measures the level the envelope follows, once per control block. Call it
+	// on the block before the EQ touches it, then process() the same block.
+	void followInput(const juce::AudioBuffer<float>& buffer, int modulatedBands, int controlRateSamples) noexcept;
+
+	// Runs the modulated bands, and those still fading out, over the first two
+	// channels in place
+	void process(juce::AudioBuffer<float>& buffer, const ChainSettings& settings, int modulatedBands, int controlRateSamples) noexcept;
+
+	// Ends the fades of the given bands at once, each in or out as modulatedBands says
+	void skipFades(int modulatedBands, int bands = allBands) noexcept;
+
+private:
+	struct Destination
+	{
+		std::atomic<float>* source = nullptr;
+		std::atomic<float>* depth = nullptr;
+
+		bool isActive() const noexcept { return source->load() != None && depth->load() != 0.f; }
+	};
+
+	void advanceSources(float inputPeak, int numSamples) noexcept;
+	float getSourceValue(const Destination& destination) const noexcept;
+	void design(const ChainSettings& settings) noexcept;
+
+	std::array<Destination, numBands> freqDestinations, gainDestinations;
+	std::atomic<float>* lfo1Rate = nullptr;
+	std::atomic<float>* lfo2Rate = nullptr;
+	std::atomic<float>* envelopeAttack = nullptr;
+	std::atomic<float>* envelopeRelease = nullptr;
+
+	double sampleRate = 48000.0;
+
+	// Source values for the current control block: LFOs in [-1, 1], envelope in [0, 1]
+	double lfo1Phase = 0.0, lfo2Phase = 0.0;
+	float lfo1 = 0.f, lfo2 = 0.f;
+	float envelopeLevel = 0.f, envelope = 0.f;
+
+	// Input peak of each control block, from followInput
+	std::vector<float> inputPeaks;
+	int numInputPeaks = 0;
+
+	// Bell state variable filters, one lane per band, see Andrew Simper's
+	// "Solving the continuous SVF equations using trapezoidal integration"
+	static constexpr int numLanes = 8;
+	alignas(32) std::array<float, numLanes> freq, gain, quality;
+	alignas(32) std::array<float, numLanes> a1, a2, a3, m1;
+	std::array<std::array<float, numLanes>, 2> ic1eq, ic2eq;
+
+	// How much of each band's bell is applied, 0 while it isn't in the matrix
+	std::array<float, numBands> wet{};
+	float wetStep = 0.f;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModulationMatrix)
+};
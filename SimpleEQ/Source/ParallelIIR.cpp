@@ -0,0 +1,272 @@
+/*
+  ==============================================================================
+
+	ParallelIIR.cpp
+
+  ==============================================================================
+*/
+
+#include "ParallelIIR.h"
+#include <complex>
+
+namespace
+{
+	using Complex = std::complex<double>;
+
+	// Each cascade section as N(w) / D(w) with w = z^-1 and D(0) = 1
+	struct CascadeSection
+	{
+		double b0, b1, b2, a1, a2;
+		int numPoles;
+		Complex poles[2];
+	};
+
+	// A pole and its residue in H(w) = direct + sum of r / (1 - p w)
+	struct Pole
+	{
+		Complex p, r;
+	};
+
+	const double unity_tolerance = 1.0e-9;
+	const double repeated_pole_distance = 1.0e-7;
+	const double real_pole_tolerance = 1.0e-12;
+	const int max_cascade_sections = ParallelIIRDesign::maxSections;
+
+	Complex numerator(const CascadeSection& s, Complex w) { return s.b0 + w * (s.b1 + w * s.b2); }
+	Complex denominator(const CascadeSection& s, Complex w) { return 1.0 + w * (s.a1 + w * s.a2); }
+}
+
+bool ParallelIIRDesign::expand(const juce::dsp::IIR::Coefficients<float>* const* cascade, int numCascadeSections)
+{
+	numSections = 0;
+	direct = 0.0;
+	residueSum = 0.0;
+
+	std::array<CascadeSection, max_cascade_sections> cs;
+	int numCs = 0;
+	double gain = 1.0;
+
+	for (int i = 0; i < numCascadeSections; ++i)
+	{
+		const auto* coefficients = cascade[i];
+		const auto* c = coefficients->getRawCoefficients();
+		CascadeSection s{};
+
+		switch (coefficients->getFilterOrder())
+		{
+			case 1: s = { c[0], c[1], 0.0, c[2], 0.0, 1, {} }; break;
+			case 2: s = { c[0], c[1], c[2], c[3], c[4], 2, {} }; break;
+			default: return false;
+		}
+
+		if (std::abs(s.b0 - 1.0) < unity_tolerance && std::abs(s.b1 - s.a1) < unity_tolerance && std::abs(s.b2 - s.a2) < unity_tolerance)
+			continue;
+
+		// The expansion needs every section to be proper in w
+		if (s.numPoles == 2 && s.a2 == 0.0)
+			return false;
+		if (s.numPoles == 1 && s.a1 == 0.0)
+			return false;
+
+		if (numCs == max_cascade_sections)
+			return false;
+
+		if (s.numPoles == 1)
+		{
+			s.poles[0] = -s.a1;
+		}
+		else
+		{
+			// Roots of z^2 + a1 z + a2
+			const auto root = std::sqrt(Complex(s.a1 * s.a1 - 4.0 * s.a2));
+			s.poles[0] = 0.5 * (-s.a1 + root);
+			s.poles[1] = 0.5 * (-s.a1 - root);
+		}
+
+		for (int p = 0; p < s.numPoles; ++p)
+			if (std::abs(s.poles[p]) >= 1.0 || std::abs(s.poles[p]) < real_pole_tolerance)
+				return false;
+
+		gain *= s.b0;
+		cs[static_cast<size_t>(numCs++)] = s;
+	}
+
+	if (numCs == 0)
+	{
+		direct = gain;
+		return true;
+	}
+
+	std::array<Pole, 2 * max_cascade_sections> poles;
+	int numPoles = 0;
+
+	for (int i = 0; i < numCs; ++i)
+		for (int p = 0; p < cs[i].numPoles; ++p)
+			poles[static_cast<size_t>(numPoles++)].p = cs[i].poles[p];
+
+	for (int i = 0; i < numPoles; ++i)
+		for (int j = i + 1; j < numPoles; ++j)
+			if (std::abs(poles[i].p - poles[j].p) < repeated_pole_distance)
+				return false;
+
+	// r = (1 - p w) H(w) at w = 1 / p, with the factor cancelled out of the owning section
+	int poleIndex = 0;
+	for (int i = 0; i < numCs; ++i)
+	{
+		for (int p = 0; p < cs[i].numPoles; ++p)
+		{
+			auto& pole = poles[static_cast<size_t>(poleIndex++)];
+			const auto w = 1.0 / pole.p;
+
+			Complex num = 1.0, den = 1.0;
+			for (int k = 0; k < numCs; ++k)
+			{
+				num *= numerator(cs[k], w);
+				if (k != i)
+					den *= denominator(cs[k], w);
+			}
+
+			if (cs[i].numPoles == 2)
+				den *= 1.0 - cs[i].poles[1 - p] * w;
+
+			pole.r = num / den;
+		}
+	}
+
+	Complex residueTotal = 0.0;
+	for (int i = 0; i < numPoles; ++i)
+	{
+		residueTotal += poles[i].r;
+		residueSum += std::abs(poles[i].r);
+	}
+
+	direct = gain - residueTotal.real();
+	residueSum += std::abs(direct);
+
+	if (residueSum > maxResidueSum)
+	{
+		numSections = 0;
+		return false;
+	}
+
+	// Conjugate pairs become one real section each, real poles are paired up
+	const Pole* pendingReal = nullptr;
+	for (int i = 0; i < numPoles; ++i)
+	{
+		const auto& pole = poles[i];
+
+		if (std::abs(pole.p.imag()) > real_pole_tolerance)
+		{
+			if (pole.p.imag() < 0.0)
+				continue;
+
+			sections[static_cast<size_t>(numSections++)] =
+			{
+				2.0 * pole.r.real(),
+				-2.0 * (pole.r * std::conj(pole.p)).real(),
+				-2.0 * pole.p.real(),
+				std::norm(pole.p)
+			};
+		}
+		else if (pendingReal == nullptr)
+		{
+			pendingReal = &pole;
+		}
+		else
+		{
+			const auto p = pendingReal->p.real(), q = pole.p.real();
+			const auto r = pendingReal->r.real(), s = pole.r.real();
+
+			sections[static_cast<size_t>(numSections++)] = { r + s, -(r * q + s * p), -(p + q), p * q };
+			pendingReal = nullptr;
+		}
+	}
+
+	if (pendingReal != nullptr)
+		sections[static_cast<size_t>(numSections++)] = { pendingReal->r.real(), 0.0, -pendingReal->p.real(), 0.0 };
+
+	return true;
+}
+
+ParallelIIR::ParallelIIR()
+{
+	b0.fill(0.f);
+	b1.fill(0.f);
+	na1.fill(0.f);
+	na2.fill(0.f);
+	reset();
+}
+
+void ParallelIIR::setDesign(const ParallelIIRDesign& design) noexcept
+{
+	direct = static_cast<float>(design.direct);
+
+	for (int i = 0; i < maxSections; ++i)
+	{
+		if (i < design.numSections)
+		{
+			const auto& s = design.sections[static_cast<size_t>(i)];
+			b0[i] = static_cast<float>(s.b0);
+			b1[i] = static_cast<float>(s.b1);
+			na1[i] = static_cast<float>(-s.a1);
+			na2[i] = static_cast<float>(-s.a2);
+		}
+		else
+		{
+			b0[i] = b1[i] = na1[i] = na2[i] = 0.f;
+			s1[i] = s2[i] = 0.f;
+		}
+	}
+
+	numSections = design.numSections;
+	numGroups = (numSections + laneWidth - 1) / laneWidth;
+}
+
+void ParallelIIR::reset() noexcept
+{
+	s1.fill(0.f);
+	s2.fill(0.f);
+}
+
+void ParallelIIR::process(float* samples, int numSamples) noexcept
+{
+#if JUCE_USE_SIMD
+	for (int i = 0; i < numSamples; ++i)
+	{
+		const auto x = samples[i];
+		const auto xv = Lane::expand(x);
+		auto sum = Lane::expand(0.f);
+
+		for (int g = 0; g < numGroups * laneWidth; g += laneWidth)
+		{
+			auto state1 = Lane::fromRawArray(s1.data() + g);
+			const auto state2 = Lane::fromRawArray(s2.data() + g);
+
+			const auto y = Lane::fromRawArray(b0.data() + g) * xv + state1;
+			state1 = Lane::fromRawArray(b1.data() + g) * xv + Lane::fromRawArray(na1.data() + g) * y + state2;
+
+			state1.copyToRawArray(s1.data() + g);
+			(Lane::fromRawArray(na2.data() + g) * y).copyToRawArray(s2.data() + g);
+			sum += y;
+		}
+
+		samples[i] = direct * x + sum.sum();
+	}
+#else
+	for (int i = 0; i < numSamples; ++i)
+	{
+		const auto x = samples[i];
+		auto sum = 0.f;
+
+		for (int s = 0; s < numSections; ++s)
+		{
+			const auto y = b0[s] * x + s1[s];
+			s1[s] = b1[s] * x + na1[s] * y + s2[s];
+			s2[s] = na2[s] * y;
+			sum += y;
+		}
+
+		samples[i] = direct * x + sum;
+	}
+#endif
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+	ParallelIIR.h
+
+	The cascade of cuts and peaks re-expressed as a direct gain plus a sum of
+	second-order sections, found by partial-fraction expansion of the whole
+	transfer function. Every section sees the same input, so one channel can be
+	spread over SIMD lanes instead of running its sections one after another.
+
+	The expansion is done in double precision. It gives up, and the caller keeps
+	the cascade, when the poles repeat (two identical peaks), a section has
+	no poles to expand around, or the residues are large enough that float
+	rounding in the sum would become audible.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+struct ParallelIIRDesign
+{
+	// Two cuts of 16 poles each plus five peaks need 21
+	static constexpr int maxSections = 24;
+
+	// Residue sums above this lose more than about 60 dB of float headroom
+	static constexpr double maxResidueSum = 1000.0;
+
+	// Numerators are first order, b2 is always zero in the parallel form
+	struct Section
+	{
+		double b0 = 0.0, b1 = 0.0, a1 = 0.0, a2 = 0.0;
+	};
+
+	// Returns false, leaving the design empty, if the cascade can't be expanded
+	// safely. Peaks at 0 dB are exact unity sections and are skipped.
+	bool expand(const juce::dsp::IIR::Coefficients<float>* const* cascade, int numCascadeSections);
+
+	std::array<Section, maxSections> sections;
+	int numSections = 0;
+	double direct = 0.0;
+	double residueSum = 0.0;
+};
+
+class ParallelIIR
+{
+public:
+	ParallelIIR();
+
+	// Keeps the state of sections that carry over, so parameter moves that
+	// only nudge the poles don't click
+	void setDesign(const ParallelIIRDesign& design) noexcept;
+	void reset() noexcept;
+
+	void process(float* samples, int numSamples) noexcept;
+
+	int getNumSections() const noexcept { return numSections; }
+
+private:
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<float>;
+	static constexpr int laneWidth = static_cast<int>(Lane::SIMDNumElements);
+#else
+	static constexpr int laneWidth = 1;
+#endif
+	static constexpr int maxSections = ParallelIIRDesign::maxSections;
+	static_assert(maxSections % 8 == 0, "sections must pad out to whole lanes");
+
+	// Transposed direct form II per section, with the feedback coefficients negated
+	alignas(32) std::array<float, maxSections> b0, b1, na1, na2, s1, s2;
+	float direct = 1.f;
+	int numSections = 0;
+	int numGroups = 0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParallelIIR)
+};
@@ -0,0 +1,182 @@
+/*
+  ==============================================================================
+
+	PlotRendering.cpp
+
+  ==============================================================================
+*/
+
+#include "PlotRendering.h"
+
+namespace
+{
+	const float plot_line_thickness = 1.5f;
+}
+
+void ColumnDecimator::reset(juce::Rectangle<float> boundsToUse)
+{
+	bounds = boundsToUse;
+	columns.clear();
+	columns.reserve(static_cast<size_t>(juce::jmax(1, juce::roundToInt(bounds.getWidth())) + 1));
+}
+
+void ColumnDecimator::addPoint(float x, float y)
+{
+	const auto column = static_cast<int>(std::floor(x));
+
+	if (columns.empty() || columns.back().x != column)
+	{
+		columns.push_back({ column, y, y, y, y });
+		return;
+	}
+
+	auto& c = columns.back();
+	c.minY = juce::jmin(c.minY, y);
+	c.maxY = juce::jmax(c.maxY, y);
+	c.last = y;
+}
+
+void ColumnDecimator::createPath(juce::Path& path, bool closeToBottom)
+{
+	path.clear();
+
+	if (columns.empty())
+		return;
+
+	path.preallocateSpace(static_cast<int>(columns.size()) * 12 + 16);
+
+	const auto bottom = bounds.getBottom();
+	const auto firstX = static_cast<float>(columns.front().x);
+
+	if (closeToBottom)
+	{
+		path.startNewSubPath(firstX, bottom);
+		path.lineTo(firstX, columns.front().first);
+	}
+	else
+	{
+		path.startNewSubPath(firstX, columns.front().first);
+	}
+
+	for (const auto& c : columns)
+	{
+		const auto x = static_cast<float>(c.x);
+		path.lineTo(x, c.first);
+
+		// A column that covers several points becomes one vertical span
+		if (c.minY != c.maxY)
+		{
+			path.lineTo(x, c.minY);
+			path.lineTo(x, c.maxY);
+			path.lineTo(x, c.last);
+		}
+	}
+
+	if (closeToBottom)
+	{
+		path.lineTo(static_cast<float>(columns.back().x), bottom);
+		path.closeSubPath();
+	}
+}
+
+//==============================================================================
+CurvePlotComponent::CurvePlotComponent()
+{
+	setColour(plotColourId, juce::Colours::orange);
+	setColour(fillColourId, juce::Colours::orange.withAlpha(0.2f));
+	setInterceptsMouseClicks(false, false);
+
+	frameScheduler->addClient(this);
+}
+
+CurvePlotComponent::~CurvePlotComponent()
+{
+	frameScheduler->removeClient(this);
+}
+
+void CurvePlotComponent::setSource(CurveSource* sourceToUse)
+{
+	source = sourceToUse;
+	rebuild(true);
+}
+
+juce::Rectangle<float> CurvePlotComponent::getCurveBounds() const
+{
+	return getLocalBounds().toFloat();
+}
+
+void CurvePlotComponent::resized()
+{
+	rebuild(true);
+}
+
+void CurvePlotComponent::frameTick()
+{
+	if (source != nullptr && source->getCurveVersion() != builtVersion)
+		rebuild(false);
+}
+
+void CurvePlotComponent::rebuild(bool repaintAll)
+{
+	auto dirty = path.getBounds().getUnion(filledPath.getBounds());
+
+	if (source == nullptr)
+	{
+		path.clear();
+		filledPath.clear();
+		builtVersion = -1;
+	}
+	else
+	{
+		builtVersion = source->getCurveVersion();
+		source->buildCurves(path, filledPath, getCurveBounds());
+	}
+
+	if (repaintAll)
+	{
+		repaint();
+		return;
+	}
+
+	dirty = dirty.getUnion(path.getBounds()).getUnion(filledPath.getBounds());
+	if (!dirty.isEmpty())
+		repaint(dirty.expanded(plot_line_thickness + 1.f).getSmallestIntegerContainer());
+}
+
+void CurvePlotComponent::paint(juce::Graphics& g)
+{
+	if (!filledPath.isEmpty())
+	{
+		g.setColour(findColour(fillColourId));
+		g.fillPath(filledPath);
+	}
+
+	if (!path.isEmpty())
+	{
+		g.setColour(findColour(plotColourId));
+		g.strokePath(path, juce::PathStrokeType(plot_line_thickness));
+	}
+}
+
+//==============================================================================
+CurvePlotItem::CurvePlotItem(foleys::MagicGUIBuilder& builder, const juce::ValueTree& node)
+	: foleys::GuiItem(builder, node)
+{
+	setColourTranslation(
+		{
+			{ "plot-color", CurvePlotComponent::plotColourId },
+			{ "plot-fill-color", CurvePlotComponent::fillColourId }
+		});
+
+	addAndMakeVisible(plot);
+}
+
+void CurvePlotItem::update()
+{
+	auto sourceID = configNode.getProperty(foleys::IDs::source, juce::String()).toString();
+	auto* plotSource = sourceID.isNotEmpty()
+		? getMagicState().getObjectWithType<foleys::MagicPlotSource>(sourceID)
+		: nullptr;
+
+	plot.setSource(dynamic_cast<CurveSource*>(plotSource));
+}
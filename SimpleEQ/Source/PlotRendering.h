@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+	PlotRendering.h
+
+	Curve drawing for the analyzer and response plots. Curves are reduced to at
+	most one vertical span per pixel column before they become a juce::Path,
+	paths are cached until their data or bounds change, and the plot component
+	only repaints the area the old and new curves cover.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "FrameScheduler.h"
+
+// Reduces a curve with increasing x to first/min/max/last per pixel column
+class ColumnDecimator
+{
+public:
+	void reset(juce::Rectangle<float> boundsToUse);
+	void addPoint(float x, float y);
+
+	// Writes the decimated curve, optionally closed down to the bottom edge for filling
+	void createPath(juce::Path& path, bool closeToBottom);
+
+private:
+	struct Column
+	{
+		int x;
+		float first, minY, maxY, last;
+	};
+
+	juce::Rectangle<float> bounds;
+	std::vector<Column> columns;
+};
+
+// Anything a CurvePlot can draw. The version must change whenever the curves would.
+class CurveSource
+{
+public:
+	virtual ~CurveSource() = default;
+
+	virtual juce::int64 getCurveVersion() const = 0;
+	virtual void buildCurves(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds) = 0;
+};
+
+// Keeps the last built paths for one set of bounds and one data version
+struct CachedCurves
+{
+	bool isValidFor(juce::Rectangle<float> boundsToCheck, juce::int64 versionToCheck) const
+	{
+		return version == versionToCheck && bounds == boundsToCheck;
+	}
+
+	void store(const juce::Path& newPath, const juce::Path& newFilledPath, juce::Rectangle<float> newBounds, juce::int64 newVersion)
+	{
+		path = newPath;
+		filledPath = newFilledPath;
+		bounds = newBounds;
+		version = newVersion;
+	}
+
+	juce::Path path, filledPath;
+	juce::Rectangle<float> bounds;
+	juce::int64 version = -1;
+};
+
+class CurvePlotComponent : public juce::Component, private FrameScheduler::Client
+{
+public:
+	enum ColourIds
+	{
+		plotColourId = 0x2001100,
+		fillColourId = 0x2001101
+	};
+
+	CurvePlotComponent();
+	~CurvePlotComponent() override;
+
+	void setSource(CurveSource* sourceToUse);
+	CurveSource* getSource() const noexcept { return source; }
+
+	void paint(juce::Graphics& g) override;
+	void resized() override;
+
+private:
+	juce::Component& getScheduledComponent() override { return *this; }
+	void frameTick() override;
+	void rebuild(bool repaintAll);
+	juce::Rectangle<float> getCurveBounds() const;
+
+	juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+	CurveSource* source = nullptr;
+	juce::int64 builtVersion = -1;
+	juce::Path path, filledPath;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CurvePlotComponent)
+};
+
+class CurvePlotItem : public foleys::GuiItem
+{
+public:
+	FOLEYS_DECLARE_GUI_FACTORY(CurvePlotItem)
+
+	CurvePlotItem(foleys::MagicGUIBuilder& builder, const juce::ValueTree& node);
+
+	void update() override;
+	juce::Component* getWrappedComponent() override { return &plot; }
+
+private:
+	CurvePlotComponent plot;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CurvePlotItem)
+};
@@ -19,7 +19,7 @@ namespace IDs
 
 auto createPostUpdateLambda(foleys::MagicProcessorState& magicState, const juce::String& plotID)
 {
-	return [plot = magicState.getObjectWithType<foleys::MagicFilterPlot>(plotID)](const SimpleEQAudioProcessor::FilterAttachment& a)
+	return [plot = magicState.getObjectWithType<ResponseCurvePlot>(plotID)](const SimpleEQAudioProcessor::FilterAttachment& a)
 	{
 		if (plot != nullptr)
 		{
@@ -43,21 +43,77 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
 {
 	FOLEYS_SET_SOURCE_PATH(__FILE__);
 	magicState.setGuiValueTree(BinaryData::SimpleEQPeaksSeparate_xml, BinaryData::SimpleEQPeaksSeparate_xmlSize);
-	analyzer = magicState.createAndAddObject<foleys::MagicAnalyser>("input");
+	analyzer = magicState.createAndAddObject<SpectrumAnalyser>("input");
+	analyzer->setSources(leftChannelFifo, rightChannelFifo, leftPreEqFifo, rightPreEqFifo);
 
 	// GUI MAGIC: add plots to be displayed in the GUI
 	for (size_t i = 0; i < attachments.size(); ++i)
 	{
 		auto name = "plot" + juce::String(i + 1);
-		magicState.createAndAddObject<foleys::MagicFilterPlot>(name);
+		bandPlots.at(i) = magicState.createAndAddObject<ResponseCurvePlot>(name);
 		attachments.at(i)->postFilterUpdate = createPostUpdateLambda(magicState, name);
 	}
 
-	plotSum = magicState.createAndAddObject<foleys::MagicFilterPlot>("plotSum");
+	plotSum = magicState.createAndAddObject<ResponseCurvePlot>("plotSum");
+
+	// Everything the audio path can run without is built in the background
+	preparation.addTask([this](double sampleRate, int samplesPerBlock)
+	{
+		leftChannelFifo.prepare(sampleRate);
+		rightChannelFifo.prepare(sampleRate);
+		leftPreEqFifo.prepare(sampleRate);
+		rightPreEqFifo.prepare(sampleRate);
+		analyzerWarmup.prepare(getTotalNumOutputChannels(), sampleRate);
+		analyzer->prepareToPlay(sampleRate, samplesPerBlock);
+		plotSum->prepareToPlay(sampleRate, samplesPerBlock);
+		for (auto* plot : bandPlots)
+			plot->prepareToPlay(sampleRate, samplesPerBlock);
+	});
+
+	bypassParameter = apvts.getRawParameterValue("Bypass");
+	analyzerBypassedParameter = apvts.getRawParameterValue("Analyzer Bypassed");
+	analyzerModeParameter = apvts.getRawParameterValue("Analyzer Mode");
+
+	for (auto* parameter : getParameters())
+		if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+			apvts.addParameterListener(withID->paramID, this);
+
+#if SIMPLEEQ_BUILD_CLAP
+	for (auto* parameter : getParameters())
+	{
+		auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter);
+		const auto id = ranged != nullptr ? static_cast<clap_id>(ranged->paramID.hashCode()) : CLAP_INVALID_ID;
+		clapIds.push_back(id);
+		if (ranged != nullptr)
+			parametersByClapId.emplace_back(id, ranged);
+		parameter->addListener(this);
+	}
+	std::sort(parametersByClapId.begin(), parametersByClapId.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+#endif
+
+	abSlots[0].settings = abSlots[1].settings = getChainSettings(apvts);
+	magicState.addTrigger("ab-toggle", [this] { toggleAB(); });
+	magicState.addTrigger("meters-reset", [this] { resetMeters(); });
+
+	frameScheduler->addMonitor(this);
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+	frameScheduler->removeMonitor(this);
+	workerPool->cancelJobsFor(this);
+	for (auto* parameter : getParameters())
+		if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+			apvts.removeParameterListener(withID->paramID, this);
+#if SIMPLEEQ_BUILD_CLAP
+	for (auto* parameter : getParameters())
+		parameter->removeListener(this);
+#endif
+	preparation.cancel();
+
+	// The analyzer belongs to magicState and outlives the FIFOs it reads
+	analyzer->release();
 }
 
 //==============================================================================
@@ -125,7 +181,13 @@ void SimpleEQAudioProcessor::changeProgramName(int index, const juce::String& ne
 //==============================================================================
 void SimpleEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
+	preparation.cancel();
 	magicState.prepareToPlay(sampleRate, samplesPerBlock);
+
+	// The background task below resizes the FIFOs the analyzer reads, so it has
+	// to be stopped here, and is only prepared again once they're ready
+	analyzer->release();
+
 	// Use this method as the place to do any pre-playback
 	// initialisation that you need..
 	juce::dsp::ProcessSpec spec;
@@ -133,23 +195,104 @@ void SimpleEQAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBloc
 	spec.numChannels = 1;
 	spec.sampleRate = sampleRate;
 
-	leftChain.prepare(spec);
-	rightChain.prepare(spec);
+	// The A/B outgoing cascade is swapped with the live one, so both are set up alike
+	for (auto* chain : { &leftChain, &rightChain, &abOutgoing.leftChain, &abOutgoing.rightChain })
+		chain->prepare(spec);
 
-	auto chainSettings = getChainSettings(apvts);
+	for (auto* cut : { &leftLowCut, &rightLowCut, &leftHighCut, &rightHighCut,
+		&abOutgoing.leftLowCut, &abOutgoing.rightLowCut, &abOutgoing.leftHighCut, &abOutgoing.rightHighCut })
+		cut->prepare(spec);
+
+	abOutgoing.buffer.setSize(2, samplesPerBlock, false, true, false);
 
+	for (auto* chain : { &leftChain, &rightChain, &abOutgoing.leftChain, &abOutgoing.rightChain })
+	{
+		chain->setBypassed<ChainPositions::LowCut>(true);
+		chain->setBypassed<ChainPositions::HighCut>(true);
+	}
+
+	loadGovernor.prepare(sampleRate, samplesPerBlock);
+	loadGovernor.setNonRealtime(isNonRealtime());
+
+	modulation.prepare(sampleRate, samplesPerBlock);
+	loudnessMeter.prepare(sampleRate);
+	truePeakMeter.reset();
+	metersResetPending.store(false);
+
+	workerPool->cancelJobsFor(this);
+	gainCompensation.prepare(sampleRate);
+	stftEqualiser.prepare(sampleRate, samplesPerBlock, 2);
+	resonanceSuppressor.prepare(sampleRate, stftEqualiser.getNumBins(), stftEqualiser.getHopSize(), 2);
+	stftWarmupRemaining = 0;
+
+	peakFadeScratch.setSize(2, samplesPerBlock, false, true, false);
+	dryBuffer.setSize(getTotalNumOutputChannels(), samplesPerBlock, false, true, false);
+	for (auto& wet : peakWet)
+		wet.reset(sampleRate, bypassFadeSeconds);
+
+	const auto bypassed = apvts.getRawParameterValue("Bypass")->load() > 0.5f;
+	globalWet.reset(sampleRate, bypassFadeSeconds);
+	globalWet.setCurrentAndTargetValue(bypassed ? 0.f : 1.f);
+	wasBypassed = bypassed;
+
+	filtersNeedUpdate = true;
 	updateFilters();
 
-	leftChannelFifo.prepare(samplesPerBlock);
-	rightChannelFifo.prepare(samplesPerBlock);
-	analyzer->prepareToPlay(sampleRate, samplesPerBlock);
-	plotSum->prepareToPlay(sampleRate, samplesPerBlock);
+	// The last estimate is as good a start as any until the new one arrives
+	outputGain.reset(sampleRate, outputGainRampSeconds);
+	outputGain.setCurrentAndTargetValue(getOutputGainTarget());
+
+	// Bands bypassed or modulated in the restored state start out of the chain
+	// rather than fading out
+	for (auto& wet : peakWet)
+		wet.setCurrentAndTargetValue(wet.getTargetValue());
+	modulation.skipFades(appliedModulatedBands);
+	retirePeakBandIfFaded<ChainPositions::Peak1>();
+	retirePeakBandIfFaded<ChainPositions::Peak2>();
+	retirePeakBandIfFaded<ChainPositions::Peak3>();
+	retirePeakBandIfFaded<ChainPositions::Peak4>();
+	retirePeakBandIfFaded<ChainPositions::Peak5>();
+
+	// Nothing to crossfade from when playback starts
+	for (auto* cut : { &leftLowCut, &rightLowCut, &leftHighCut, &rightHighCut })
+		cut->reset();
+
+	pendingSlot.store(-1);
+	abGain.reset(sampleRate, abFadeSeconds);
+	abGain.setCurrentAndTargetValue(1.f);
+	abCrossfade.reset(sampleRate, CrossfadingCut::crossfadeSeconds);
+	abCrossfade.setCurrentAndTargetValue(1.f);
+	abSlots[static_cast<size_t>(activeSlot.load())].settings = appliedSettings;
+	for (auto& slot : abSlots)
+		designSlot(slot, sampleRate);
+
+	setLatencySamples(latencyToReport.load());
+
+	// The IIR chain above is all the audio path needs; the rest follows
+	// asynchronously and is switched on once preparation.isReady()
+	preparation.start(sampleRate, samplesPerBlock);
+}
+
+size_t SimpleEQAudioProcessor::getAnalyzerMemoryUsageInBytes() const
+{
+	return leftChannelFifo.getMemoryUsageInBytes()
+		+ rightChannelFifo.getMemoryUsageInBytes()
+		+ leftPreEqFifo.getMemoryUsageInBytes()
+		+ rightPreEqFifo.getMemoryUsageInBytes()
+		+ analyzerWarmup.getMemoryUsageInBytes();
 }
 
 void SimpleEQAudioProcessor::releaseResources()
 {
 	// When playback stops, you can use this as an opportunity to free up any
 	// spare memory, etc.
+	preparation.cancel();
+
+	if (isNonRealtime())
+		juce::Logger::writeToLog("SimpleEQ: render " + loudnessMeter.getReport() + ", " + truePeakMeter.getReport());
+
+	// What the background work has cost every instance so far
+	juce::Logger::writeToLog(workerPool->getStatsReport());
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -181,6 +324,12 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts)
 void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
 	juce::ScopedNoDenormals noDenormals;
+	workerPool->avoidCurrentCore();
+	loadGovernor.setNonRealtime(isNonRealtime());
+	loadGovernor.update();
+	juce::AudioProcessLoadMeasurer::ScopedTimer loadTimer(loadGovernor.getLoadMeasurer(), buffer.getNumSamples());
+	const auto& quality = loadGovernor.getCurrentQuality();
+
 	auto totalNumInputChannels = getTotalNumInputChannels();
 	auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -193,23 +342,252 @@ void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce
 	for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
 		buffer.clear(i, 0, buffer.getNumSamples());
 
-	updateFilters();
+	const auto bypassed = bypassParameter->load() > 0.5f;
+	globalWet.setTargetValue(bypassed || stftWarmupRemaining > 0 ? 0.f : 1.f);
+
+	if (bypassed && !globalWet.isSmoothing())
+	{
+		// The reported latency still applies, so the input is delayed by it and
+		// stays in time with what the host compensated for. The load measurer
+		// above keeps timing too: a bypassed block is nearly free, so the load
+		// falls and the governor steps back up to full quality meanwhile.
+		if (stftActive)
+			stftEqualiser.delayDry(buffer, 2);
+
+		// The input is already in place. An A/B switch has nothing to dip while bypassed.
+		if (const auto pending = pendingSlot.load(); pending >= 0 && !abParametersSyncing.load())
+		{
+			swapInSlot(abSlots[static_cast<size_t>(pending)]);
+			activeSlot.store(pending);
+			pendingSlot.store(-1);
+			abGain.setCurrentAndTargetValue(1.f);
+		}
+
+		// Nothing of the EQ's to measure, the meters hold until it resumes
+		wasBypassed = true;
+		analyzerWasFed = false;
+		return;
+	}
+
+	if (wasBypassed)
+	{
+		// The filters still hold whatever they were doing when the bypass started
+		resetFilterState();
+		wasBypassed = false;
+
+		if (stftActive)
+		{
+			stftWarmupRemaining = stftEqualiser.getLatencySamples();
+			globalWet.setTargetValue(0.f);
+		}
+	}
+
+	// While the STFT runs the dry signal always goes through the delay, so
+	// it's in line whenever a bypass fade needs it
+	const auto crossfadingBypass = globalWet.isSmoothing() || globalWet.getCurrentValue() < 1.f;
+	const auto delayDry = stftActive;
+	if (crossfadingBypass || delayDry)
+	{
+		dryBuffer.makeCopyOf(buffer, true);
+		if (delayDry)
+			stftEqualiser.delayDry(dryBuffer, 2);
+	}
+
+	// An A/B switch in the cascade swaps in the other slot at once and
+	// crossfades from the cascade it replaced. Elsewhere it dips the output,
+	// swaps at the bottom of the dip and comes back up. The parameters are
+	// caught up on the message thread, so nothing is redesigned from them
+	// until that has finished.
+	const auto pending = pendingSlot.load();
+	if (pending >= 0 && !abGain.isSmoothing() && !abCrossfade.isSmoothing())
+	{
+		if (activeMode == ProcessingMode::Cascade && abGain.getCurrentValue() >= 1.f)
+		{
+			swapOutCascade();
+			swapInSlot(abSlots[static_cast<size_t>(pending)]);
+			activeSlot.store(pending);
+			pendingSlot.store(-1);
+			abCrossfade.setCurrentAndTargetValue(0.f);
+			abCrossfade.setTargetValue(1.f);
+		}
+		else if (abGain.getCurrentValue() > 0.f)
+		{
+			abGain.setTargetValue(0.f);
+		}
+		else
+		{
+			swapInSlot(abSlots[static_cast<size_t>(pending)]);
+			activeSlot.store(pending);
+			pendingSlot.store(-1);
+			abGain.setTargetValue(1.f);
+		}
+	}
+
+	if (pendingSlot.load() < 0 && !abParametersSyncing.load() && (filtersNeedUpdate || parametersChanged.exchange(false)))
+		updateFilters();
+
+	const auto analyzerReady = preparation.isReady()
+		&& analyzerBypassedParameter->load() < 0.5f;
+	const auto feedAnalyzer = analyzerReady && editorVisible.load(std::memory_order_relaxed);
+
+	if (feedAnalyzer)
+	{
+		analyzer->setMode(static_cast<SpectrumAnalyser::Mode>(analyzerModeParameter->load()));
+		analyzer->setQuality(quality.analyzerFftOrder, quality.analyzerFrameDivisor);
+
+		if (!analyzerWasFed && !analyzerWarmup.isEmpty())
+		{
+			// The history is post-EQ only, it stands in for both sides until real input arrives
+			const auto& history = analyzerWarmup.getHistory();
+			leftPreEqFifo.update(history);
+			rightPreEqFifo.update(history);
+			leftChannelFifo.update(history);
+			rightChannelFifo.update(history);
+			analyzerWarmup.reset();
+		}
+
+		leftPreEqFifo.update(buffer);
+		rightPreEqFifo.update(buffer);
+	}
+
+	// The envelope source reads the input, not what the EQ made of it
+	modulation.followInput(buffer, appliedModulatedBands, quality.controlRateSamples);
 
 	juce::dsp::AudioBlock<float> block(buffer);
 
 	auto leftBlock = block.getSingleChannelBlock(0);
 	auto rightBlock = block.getSingleChannelBlock(1);
 
-	juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-	juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+	const auto numSamples = static_cast<int>(leftBlock.getNumSamples());
+
+	const auto peaksFading = std::any_of(peakWet.begin(), peakWet.end(),
+		[](const juce::SmoothedValue<float>& wet) { return wet.isSmoothing(); });
+
+	switch (activeMode)
+	{
+		case ProcessingMode::Parallel:
+			leftParallel.process(leftBlock.getChannelPointer(0), numSamples);
+			rightParallel.process(rightBlock.getChannelPointer(0), numSamples);
+			break;
+
+		case ProcessingMode::BlockStateSpace:
+			leftBlockFilter.process(leftBlock.getChannelPointer(0), numSamples);
+			rightBlockFilter.process(rightBlock.getChannelPointer(0), numSamples);
+			break;
+
+		case ProcessingMode::Stft:
+			// All in the STFT below
+			break;
+
+		case ProcessingMode::Cascade:
+		default:
+		{
+			auto* left = leftBlock.getChannelPointer(0);
+			auto* right = rightBlock.getChannelPointer(0);
+
+			// A block longer than the host promised has no room, its crossfade ends below
+			const auto abCrossfading = abCrossfade.isSmoothing() && numSamples <= abOutgoing.buffer.getNumSamples();
+			if (abCrossfading)
+			{
+				abOutgoing.buffer.copyFrom(0, 0, left, numSamples);
+				abOutgoing.buffer.copyFrom(1, 0, right, numSamples);
+			}
+
+			leftLowCut.process(left, numSamples);
+			rightLowCut.process(right, numSamples);
+
+			if (peaksFading)
+			{
+				processPeakBand<ChainPositions::Peak1>(left, right, numSamples);
+				processPeakBand<ChainPositions::Peak2>(left, right, numSamples);
+				processPeakBand<ChainPositions::Peak3>(left, right, numSamples);
+				processPeakBand<ChainPositions::Peak4>(left, right, numSamples);
+				processPeakBand<ChainPositions::Peak5>(left, right, numSamples);
+			}
+			else
+			{
+				juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
+				juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
+				leftChain.process(leftContext);
+				rightChain.process(rightContext);
+			}
+
+			leftHighCut.process(left, numSamples);
+			rightHighCut.process(right, numSamples);
+
+			if (abCrossfading)
+				crossfadeFromOutgoing(left, right, numSamples);
+			break;
+		}
+	}
+
+	// A crossfade the cascade didn't run just ends
+	if (abCrossfade.isSmoothing() && (activeMode != ProcessingMode::Cascade || numSamples > abOutgoing.buffer.getNumSamples()))
+		abCrossfade.setCurrentAndTargetValue(1.f);
+
+	if (stftActive)
+		stftEqualiser.process(buffer, 2, activeMode == ProcessingMode::Stft, appliedSuppression ? &resonanceSuppressor : nullptr);
+
+	if (peaksFading)
+	{
+		// The other realisations switch bands without a fade, the ramps just run out
+		if (activeMode != ProcessingMode::Cascade)
+			for (auto& wet : peakWet)
+				wet.skip(numSamples);
+
+		retirePeakBandIfFaded<ChainPositions::Peak1>();
+		retirePeakBandIfFaded<ChainPositions::Peak2>();
+		retirePeakBandIfFaded<ChainPositions::Peak3>();
+		retirePeakBandIfFaded<ChainPositions::Peak4>();
+		retirePeakBandIfFaded<ChainPositions::Peak5>();
+	}
+
+	modulation.process(buffer, appliedSettings, appliedModulatedBands, quality.controlRateSamples);
+
+	if (const auto status = SignalHealth::check(buffer, totalNumOutputChannels); status != SignalHealth::Status::Healthy)
+	{
+		resetFilterState();
+		buffer.clear();
+		lastHealthStatus.store(static_cast<int>(status));
+		healthResets.fetch_add(1);
+	}
 
-	leftChain.process(leftContext);
-	rightChain.process(rightContext);
+	if (abGain.isSmoothing() || abGain.getCurrentValue() < 1.f)
+		abGain.applyGain(buffer, buffer.getNumSamples());
 
-	leftChannelFifo.update(buffer);
-	rightChannelFifo.update(buffer);
+	outputGain.setTargetValue(getOutputGainTarget());
+	gain.store(outputGain.getTargetValue(), std::memory_order_relaxed);
+	if (outputGain.isSmoothing() || outputGain.getCurrentValue() != 1.f)
+		outputGain.applyGain(buffer, buffer.getNumSamples());
+
+	if (crossfadingBypass)
+	{
+		const auto numChannels = juce::jmin(buffer.getNumChannels(), dryBuffer.getNumChannels());
+		for (int i = 0; i < buffer.getNumSamples(); ++i)
+		{
+			const auto wet = globalWet.getNextValue();
+			for (int ch = 0; ch < numChannels; ++ch)
+			{
+				const auto dry = dryBuffer.getSample(ch, i);
+				buffer.setSample(ch, i, dry + wet * (buffer.getSample(ch, i) - dry));
+			}
+		}
+	}
+
+	stftWarmupRemaining = juce::jmax(0, stftWarmupRemaining - buffer.getNumSamples());
+	meterOutput(buffer);
+
+	if (feedAnalyzer)
+	{
+		leftChannelFifo.update(buffer);
+		rightChannelFifo.update(buffer);
+	}
+	else if (analyzerReady)
+	{
+		analyzerWarmup.push(buffer);
+	}
 
-	analyzer->pushSamples(buffer);
+	analyzerWasFed = feedAnalyzer;
 }
 
 ////==============================================================================
@@ -236,6 +614,198 @@ void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce
 //	}
 //}
 
+void SimpleEQAudioProcessor::parameterChanged(const juce::String&, float)
+{
+	parametersChanged.store(true);
+}
+
+#if SIMPLEEQ_BUILD_CLAP
+thread_local bool SimpleEQAudioProcessor::applyingClapEvents = false;
+
+clap_process_status SimpleEQAudioProcessor::clap_direct_process(const clap_process* process) noexcept
+{
+	sendClapEvents(process->out_events);
+
+	const auto numFrames = static_cast<int>(process->frames_count);
+	if (process->audio_outputs_count == 0 || process->audio_inputs_count == 0)
+		return CLAP_PROCESS_CONTINUE;
+
+	auto& input = process->audio_inputs[0];
+	auto& output = process->audio_outputs[0];
+	const auto numChannels = static_cast<int>(juce::jmin(input.channel_count, output.channel_count));
+
+	// processBlock works in place on the output
+	for (int ch = 0; ch < numChannels; ++ch)
+		if (output.data32[ch] != input.data32[ch])
+			juce::FloatVectorOperations::copy(output.data32[ch], input.data32[ch], numFrames);
+
+	juce::MidiBuffer noMidi;
+	auto processRange = [this, &output, numChannels, &noMidi](int start, int end)
+	{
+		if (end <= start)
+			return;
+
+		juce::AudioBuffer<float> range(output.data32, numChannels, start, end - start);
+		processBlock(range, noMidi);
+	};
+
+	// Events arrive sorted by time. Without any the block goes through in one piece.
+	const auto* events = process->in_events;
+	const auto numEvents = events->size(events);
+	int start = 0;
+
+	for (uint32_t e = 0; e < numEvents; ++e)
+	{
+		const auto* header = events->get(events, e);
+		if (header->space_id != CLAP_CORE_EVENT_SPACE_ID || header->type != CLAP_EVENT_PARAM_VALUE)
+			continue;
+
+		const auto time = juce::jlimit(start, numFrames, static_cast<int>(header->time));
+		processRange(start, time);
+		start = time;
+
+		applyClapEvent(*reinterpret_cast<const clap_event_param_value*>(header));
+	}
+
+	processRange(start, numFrames);
+	return CLAP_PROCESS_CONTINUE;
+}
+
+void SimpleEQAudioProcessor::clap_direct_paramsFlush(const clap_input_events* in, const clap_output_events* out) noexcept
+{
+	// Nothing is processing, so there is no block to split
+	const auto numEvents = in->size(in);
+	for (uint32_t e = 0; e < numEvents; ++e)
+	{
+		const auto* header = in->get(in, e);
+		if (header->space_id == CLAP_CORE_EVENT_SPACE_ID && header->type == CLAP_EVENT_PARAM_VALUE)
+			applyClapEvent(*reinterpret_cast<const clap_event_param_value*>(header));
+	}
+
+	sendClapEvents(out);
+}
+
+void SimpleEQAudioProcessor::applyClapEvent(const clap_event_param_value& event)
+{
+	// The extensions hand out a JUCEParameterVariant as the cookie, hosts may
+	// leave it out and only give the id. Values are in the parameter's own
+	// range, the one advertised in its param info.
+	juce::AudioProcessorParameter* parameter = nullptr;
+	const juce::RangedAudioParameter* ranged = nullptr;
+
+	if (const auto* variant = static_cast<const clap_juce_extensions::JUCEParameterVariant*>(event.cookie); variant != nullptr)
+	{
+		parameter = variant->processorParam;
+		ranged = variant->rangedParameter;
+	}
+	else
+	{
+		const auto found = std::lower_bound(parametersByClapId.begin(), parametersByClapId.end(), event.param_id,
+			[](const auto& entry, clap_id id) { return entry.first < id; });
+		if (found != parametersByClapId.end() && found->first == event.param_id)
+		{
+			parameter = found->second;
+			ranged = found->second;
+		}
+	}
+
+	if (parameter == nullptr)
+		return;
+
+	auto value = static_cast<float>(event.value);
+	if (ranged != nullptr)
+		value = ranged->convertTo0to1(value);
+
+	const juce::ScopedValueSetter<bool> applying(applyingClapEvents, true);
+	parameter->setValue(value);
+	parameter->sendValueChangedMessageToListeners(value);
+}
+
+void SimpleEQAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+	// Host automation and state changes reach the listeners on the audio thread
+	// or from the events above, only the editor edits on the message thread
+	if (applyingClapEvents || !juce::MessageManager::existsAndIsCurrentThread())
+		return;
+
+	if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(getParameters()[parameterIndex]))
+		queueClapEvent(CLAP_EVENT_PARAM_VALUE, parameterIndex, ranged->convertFrom0to1(newValue));
+}
+
+void SimpleEQAudioProcessor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting)
+{
+	if (juce::MessageManager::existsAndIsCurrentThread())
+		queueClapEvent(gestureIsStarting ? CLAP_EVENT_PARAM_GESTURE_BEGIN : CLAP_EVENT_PARAM_GESTURE_END, parameterIndex, 0.0);
+}
+
+void SimpleEQAudioProcessor::queueClapEvent(uint16_t type, int parameterIndex, double value)
+{
+	if (!clapEventsDrained.load() || !juce::isPositiveAndBelow(parameterIndex, static_cast<int>(clapIds.size())))
+		return;
+
+	// A full queue drops the event, it holds far more than a drag makes between two blocks
+	const auto scope = clapOutFifo.write(1);
+	if (scope.blockSize1 > 0)
+		clapOutEvents[static_cast<size_t>(scope.startIndex1)] = { type, clapIds[static_cast<size_t>(parameterIndex)], value };
+}
+
+void SimpleEQAudioProcessor::sendClapEvents(const clap_output_events* out)
+{
+	clapEventsDrained.store(true);
+	if (out == nullptr)
+		return;
+
+	// Everything is pushed at the start of the block
+	const auto scope = clapOutFifo.read(clapOutFifo.getNumReady());
+	auto send = [out](const ClapOutEvent& queued)
+	{
+		if (queued.type == CLAP_EVENT_PARAM_VALUE)
+		{
+			clap_event_param_value event{};
+			event.header = { sizeof(event), 0, CLAP_CORE_EVENT_SPACE_ID, CLAP_EVENT_PARAM_VALUE, 0 };
+			event.param_id = queued.paramId;
+			event.note_id = event.port_index = event.channel = event.key = -1;
+			event.value = queued.value;
+			out->try_push(out, &event.header);
+		}
+		else
+		{
+			clap_event_param_gesture event{};
+			event.header = { sizeof(event), 0, CLAP_CORE_EVENT_SPACE_ID, queued.type, 0 };
+			event.param_id = queued.paramId;
+			out->try_push(out, &event.header);
+		}
+	};
+
+	for (int i = 0; i < scope.blockSize1; ++i)
+		send(clapOutEvents[static_cast<size_t>(scope.startIndex1 + i)]);
+	for (int i = 0; i < scope.blockSize2; ++i)
+		send(clapOutEvents[static_cast<size_t>(scope.startIndex2 + i)]);
+}
+#endif
+
+juce::AudioProcessorParameter* SimpleEQAudioProcessor::getBypassParameter() const
+{
+	return apvts.getParameter("Bypass");
+}
+
+void SimpleEQAudioProcessor::resetFilterState()
+{
+	leftChain.reset();
+	rightChain.reset();
+	for (auto* cut : { &leftLowCut, &rightLowCut, &leftHighCut, &rightHighCut })
+		cut->reset();
+	for (auto* realisation : { &leftParallel, &rightParallel })
+		realisation->reset();
+	for (auto* realisation : { &leftBlockFilter, &rightBlockFilter })
+		realisation->reset();
+	// The dry delay keeps going, a bypass fade lines up against it
+	stftEqualiser.resetFrames();
+	resonanceSuppressor.reset();
+	modulation.reset();
+	abCrossfade.setCurrentAndTargetValue(1.f);
+}
+
 void updateCoefficients(Coefficients& old, const Coefficients& replacements)
 {
 	*old = *replacements;
@@ -250,59 +820,267 @@ Coefficients makePeakFilter(float freq, float q, float gainInDB, double sampleRa
 		juce::Decibels::decibelsToGain(gainInDB));
 }
 
+std::vector<Coefficients> makeChainSections(const ChainSettings& settings, double sampleRate, int excludedPeaks)
+{
+	const std::array<std::array<float, 3>, 5> peaks
+	{ {
+		{ settings.peak1Freq, settings.peak1Quality, settings.peak1GainInDecibels },
+		{ settings.peak2Freq, settings.peak2Quality, settings.peak2GainInDecibels },
+		{ settings.peak3Freq, settings.peak3Quality, settings.peak3GainInDecibels },
+		{ settings.peak4Freq, settings.peak4Quality, settings.peak4GainInDecibels },
+		{ settings.peak5Freq, settings.peak5Quality, settings.peak5GainInDecibels }
+	} };
+
+	std::vector<Coefficients> sections;
+
+	if (!settings.isLowCutOff())
+		for (auto* c : makeCutFilter(settings.lowCutFreq, sampleRate, settings.lowCutSlope, lowCutButterworthMethod))
+			sections.push_back(c);
+
+	for (size_t i = 0; i < peaks.size(); ++i)
+		if ((excludedPeaks & (1 << i)) == 0)
+			sections.push_back(makePeakFilter(peaks[i][0], peaks[i][1], peaks[i][2], sampleRate));
+
+	if (!settings.isHighCutOff())
+		for (auto* c : makeCutFilter(settings.highCutFreq, sampleRate, settings.highCutSlope, highCutButterworthMethod))
+			sections.push_back(c);
+
+	return sections;
+}
+
 void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings& chainSettings)
 {
-	auto peak1Coefficients = makePeakFilter(
-		chainSettings.peak1Freq,
-		chainSettings.peak1Quality,
-		chainSettings.peak1GainInDecibels,
-		getSampleRate());
-	auto peak2Coefficients = makePeakFilter(
-		chainSettings.peak2Freq,
-		chainSettings.peak2Quality,
-		chainSettings.peak2GainInDecibels,
-		getSampleRate());
-	auto peak3Coefficients = makePeakFilter(
-		chainSettings.peak3Freq,
-		chainSettings.peak3Quality,
-		chainSettings.peak3GainInDecibels,
-		getSampleRate());
-	auto peak4Coefficients = makePeakFilter(
-		chainSettings.peak4Freq,
-		chainSettings.peak4Quality,
-		chainSettings.peak4GainInDecibels,
-		getSampleRate());
-	auto peak5Coefficients = makePeakFilter(
-		chainSettings.peak5Freq,
-		chainSettings.peak5Quality,
-		chainSettings.peak5GainInDecibels,
-		getSampleRate());
-
-	attachment1.coefficients = peak1Coefficients;
-	attachment2.coefficients = peak2Coefficients;
-	attachment3.coefficients = peak3Coefficients;
-	attachment4.coefficients = peak4Coefficients;
-	attachment5.coefficients = peak5Coefficients;
-
-	updateCoefficients(leftChain.get<ChainPositions::Peak1>().coefficients, peak1Coefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak1>().coefficients, peak1Coefficients);
-	updateCoefficients(leftChain.get<ChainPositions::Peak2>().coefficients, peak2Coefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak2>().coefficients, peak2Coefficients);
-	updateCoefficients(leftChain.get<ChainPositions::Peak3>().coefficients, peak3Coefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak3>().coefficients, peak3Coefficients);
-	updateCoefficients(leftChain.get<ChainPositions::Peak4>().coefficients, peak4Coefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak4>().coefficients, peak4Coefficients);
-	updateCoefficients(leftChain.get<ChainPositions::Peak5>().coefficients, peak5Coefficients);
-	updateCoefficients(rightChain.get<ChainPositions::Peak5>().coefficients, peak5Coefficients);
+	// This runs on the audio thread whenever a parameter moves, so the five
+	// peaks are designed as one batch and written into the coefficients the
+	// chains already hold instead of newly allocated ones
+	FastCoefficientDesign::PeakBatch batch;
+	const std::array<std::array<float, 3>, 5> peaks
+	{ {
+		{ chainSettings.peak1Freq, chainSettings.peak1Quality, chainSettings.peak1GainInDecibels },
+		{ chainSettings.peak2Freq, chainSettings.peak2Quality, chainSettings.peak2GainInDecibels },
+		{ chainSettings.peak3Freq, chainSettings.peak3Quality, chainSettings.peak3GainInDecibels },
+		{ chainSettings.peak4Freq, chainSettings.peak4Quality, chainSettings.peak4GainInDecibels },
+		{ chainSettings.peak5Freq, chainSettings.peak5Quality, chainSettings.peak5GainInDecibels }
+	} };
+
+	for (size_t i = 0; i < peaks.size(); ++i)
+	{
+		batch.freq[i] = peaks[i][0];
+		batch.quality[i] = peaks[i][1];
+		batch.gainInDecibels[i] = peaks[i][2];
+	}
+
+	FastCoefficientDesign::designPeaks(batch, getSampleRate());
+
+	// After an A/B swap both chains share the slot's coefficients, writing
+	// them twice does no harm
+	auto write = [&batch](int lane, Filter& left, Filter& right, FilterAttachment& attachment)
+	{
+		FastCoefficientDesign::copyToCoefficients(batch, lane, *left.coefficients);
+		FastCoefficientDesign::copyToCoefficients(batch, lane, *right.coefficients);
+		attachment.coefficients = left.coefficients;
+	};
+
+	write(0, leftChain.get<ChainPositions::Peak1>(), rightChain.get<ChainPositions::Peak1>(), attachment1);
+	write(1, leftChain.get<ChainPositions::Peak2>(), rightChain.get<ChainPositions::Peak2>(), attachment2);
+	write(2, leftChain.get<ChainPositions::Peak3>(), rightChain.get<ChainPositions::Peak3>(), attachment3);
+	write(3, leftChain.get<ChainPositions::Peak4>(), rightChain.get<ChainPositions::Peak4>(), attachment4);
+	write(4, leftChain.get<ChainPositions::Peak5>(), rightChain.get<ChainPositions::Peak5>(), attachment5);
 }
 
 void SimpleEQAudioProcessor::handleAsyncUpdate()
 {
-	std::vector<juce::dsp::IIR::Coefficients<float>::Ptr> coefficients;
-	for (auto* a : attachments)
-		coefficients.push_back(a->coefficients);
+	if (stftDesignPending.exchange(false))
+		requestStftDesign();
+
+	if (compensationDesignPending.exchange(false))
+		requestCompensationDesign();
+
+	if (const auto latency = latencyToReport.load(); latency != getLatencySamples())
+		setLatencySamples(latency);
+}
+
+void SimpleEQAudioProcessor::requestStftDesign()
+{
+	const auto sampleRate = getSampleRate();
+	if (sampleRate <= 0.0)
+		return;
+
+	const auto settings = getChainSettings(apvts);
+	const auto excluded = settings.getBypassedPeaks() | stftExcludedBands.load();
+	const auto numBins = stftEqualiser.getNumBins();
+	const auto generation = ++stftDesignGeneration;
+
+	// A request made since supersedes this one, so it is dropped rather than designed
+	// or published over the newer curve
+	auto isStale = [this, generation] { return generation != stftDesignGeneration.load(); };
+
+	workerPool->addJob(this, WorkerPool::TaskType::CoefficientDesign, [this, settings, excluded, sampleRate, numBins, isStale]
+	{
+		if (isStale())
+			return;
+
+		const auto designed = makeChainSections(settings, sampleRate, excluded);
+
+		std::vector<const juce::dsp::IIR::Coefficients<float>*> sections;
+		for (auto& c : designed)
+			sections.push_back(c.get());
+
+		std::vector<float> magnitudes(static_cast<size_t>(numBins));
+		StftEqualiser::designMagnitudes(sections.data(), static_cast<int>(sections.size()), sampleRate, magnitudes.data(), numBins);
+		if (!isStale())
+			stftEqualiser.setMagnitudes(magnitudes.data(), numBins);
+	});
+}
+
+void SimpleEQAudioProcessor::requestCompensationDesign()
+{
+	const auto sampleRate = getSampleRate();
+	if (sampleRate <= 0.0)
+		return;
+
+	// Bypassed bands don't change the level, the modulated ones count at their set values
+	const auto settings = getChainSettings(apvts);
+	const auto generation = ++compensationDesignGeneration;
+
+	// Only the newest request's estimate is stored, as for the STFT curves
+	auto isStale = [this, generation] { return generation != compensationDesignGeneration.load(); };
+
+	workerPool->addJob(this, WorkerPool::TaskType::CoefficientDesign, [this, settings, sampleRate, isStale]
+	{
+		if (isStale())
+			return;
+
+		const auto designed = makeChainSections(settings, sampleRate, settings.getBypassedPeaks());
+
+		std::vector<const juce::dsp::IIR::Coefficients<float>*> sections;
+		for (auto& c : designed)
+			sections.push_back(c.get());
 
-	plotSum->setIIRCoefficients(gain, coefficients, maxLevel);
+		const auto compensation = gainCompensation.getCompensationDb(sections.data(), static_cast<int>(sections.size()));
+		if (!isStale())
+			compensationDb.store(compensation);
+	});
+}
+
+float SimpleEQAudioProcessor::getOutputGainTarget() const noexcept
+{
+	const auto totalDb = outputGainDb + (autoGainEnabled ? compensationDb.load(std::memory_order_relaxed) : 0.f);
+	return juce::Decibels::decibelsToGain(juce::jlimit(-GainCompensation::maxCompensationDb, GainCompensation::maxCompensationDb, totalDb));
+}
+
+void SimpleEQAudioProcessor::initialiseBuilder(foleys::MagicGUIBuilder& builder)
+{
+	foleys::MagicProcessor::initialiseBuilder(builder);
+	builder.registerFactory("Spectrogram", &SpectrogramItem::factory);
+	builder.registerFactory("CurvePlot", &CurvePlotItem::factory);
+}
+
+void SimpleEQAudioProcessor::monitorTick()
+{
+	// Closed, hidden and minimised editors all count as not visible
+	auto visible = false;
+	if (auto* editor = getActiveEditor())
+	{
+		visible = editor->isShowing();
+		if (auto* peer = editor->getPeer())
+			visible = visible && !peer->isMinimised();
+	}
+
+	editorVisible.store(visible);
+
+	if (visible)
+	{
+		updateResponsePlots();
+		updateMeterLabels();
+	}
+
+	if (const auto resets = healthResets.load(); resets != loggedHealthResets)
+	{
+		const auto status = static_cast<SignalHealth::Status>(lastHealthStatus.load());
+		juce::Logger::writeToLog("SimpleEQ: filters reset after " + juce::String(SignalHealth::getDescription(status))
+			+ " (" + juce::String(resets - loggedHealthResets) + " times, " + juce::String(resets) + " in total)");
+		loggedHealthResets = resets;
+	}
+
+	if (const auto tier = getQualityTier(); tier != loggedQualityTier)
+	{
+		const auto& quality = quality_tiers[static_cast<size_t>(tier)];
+		juce::Logger::writeToLog("SimpleEQ: quality tier " + juce::String(loggedQualityTier) + " -> " + juce::String(tier)
+			+ " at " + juce::String(100.0 * loadGovernor.getLoad(), 0) + "% load (analyzer FFT " + juce::String(1 << quality.analyzerFftOrder)
+			+ ", every " + juce::String(quality.analyzerFrameDivisor) + " blocks, control rate " + juce::String(quality.controlRateSamples) + " samples)");
+		loggedQualityTier = tier;
+	}
+}
+
+void SimpleEQAudioProcessor::updateMeterLabels()
+{
+	auto setLabel = [this](const char* property, float value, const char* unit)
+	{
+		magicState.getPropertyAsValue(property).setValue(std::isfinite(value) ? juce::String(value, 1) + unit : juce::String("-inf") + unit);
+	};
+
+	setLabel("meters:integrated", loudnessMeter.getIntegrated(), " LUFS");
+	setLabel("meters:short-term", loudnessMeter.getShortTerm(), " LUFS");
+	setLabel("meters:true-peak-left", truePeakMeter.getTruePeakDb(0), " dBTP");
+	setLabel("meters:true-peak-right", truePeakMeter.getTruePeakDb(1), " dBTP");
+}
+
+void SimpleEQAudioProcessor::meterOutput(const juce::AudioBuffer<float>& buffer)
+{
+	if (metersResetPending.exchange(false))
+	{
+		loudnessMeter.reset();
+		truePeakMeter.reset();
+	}
+
+	loudnessMeter.process(buffer);
+	truePeakMeter.process(buffer);
+}
+
+void SimpleEQAudioProcessor::updateResponsePlots()
+{
+	const auto sampleRate = getSampleRate();
+	if (sampleRate <= 0.0)
+		return;
+
+	const auto chainSettings = getChainSettings(apvts);
+	const auto outputGainToPlot = gain.load();
+	if (chainSettings == plottedSettings && sampleRate == plottedSampleRate && outputGainToPlot == plottedGain)
+		return;
+
+	plottedSettings = chainSettings;
+	plottedSampleRate = sampleRate;
+	plottedGain = outputGainToPlot;
+
+	const std::array<Coefficients, 5> peaks
+	{
+		makePeakFilter(chainSettings.peak1Freq, chainSettings.peak1Quality, chainSettings.peak1GainInDecibels, sampleRate),
+		makePeakFilter(chainSettings.peak2Freq, chainSettings.peak2Quality, chainSettings.peak2GainInDecibels, sampleRate),
+		makePeakFilter(chainSettings.peak3Freq, chainSettings.peak3Quality, chainSettings.peak3GainInDecibels, sampleRate),
+		makePeakFilter(chainSettings.peak4Freq, chainSettings.peak4Quality, chainSettings.peak4GainInDecibels, sampleRate),
+		makePeakFilter(chainSettings.peak5Freq, chainSettings.peak5Quality, chainSettings.peak5GainInDecibels, sampleRate)
+	};
+
+	std::vector<Coefficients> sections;
+	const auto bypassedPeaks = chainSettings.getBypassedPeaks();
+
+	for (size_t i = 0; i < peaks.size(); ++i)
+	{
+		bandPlots.at(i)->setIIRCoefficients(peaks[i], maxLevel);
+		if ((bypassedPeaks & (1 << i)) == 0)
+			sections.push_back(peaks[i]);
+	}
+
+	if (!chainSettings.isLowCutOff())
+		for (auto* c : makeCutFilter(chainSettings.lowCutFreq, sampleRate, chainSettings.lowCutSlope, lowCutButterworthMethod))
+			sections.push_back(c);
+
+	if (!chainSettings.isHighCutOff())
+		for (auto* c : makeCutFilter(chainSettings.highCutFreq, sampleRate, chainSettings.highCutSlope, highCutButterworthMethod))
+			sections.push_back(c);
+
+	plotSum->setIIRCoefficients(outputGainToPlot, sections, maxLevel);
 }
 
 SimpleEQAudioProcessor::FilterAttachment::FilterAttachment(
@@ -338,9 +1116,13 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
 	settings.peak5Quality = apvts.getRawParameterValue("Peak5 Quality")->load();
 	settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
 	settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
-	//settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load();
-	//settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load();
-	//settings.peak1Bypassed = apvts.getRawParameterValue("Peak Bypassed")->load();
+	settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
+	settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
+	settings.peak1Bypassed = apvts.getRawParameterValue("Peak1 Bypassed")->load() > 0.5f;
+	settings.peak2Bypassed = apvts.getRawParameterValue("Peak2 Bypassed")->load() > 0.5f;
+	settings.peak3Bypassed = apvts.getRawParameterValue("Peak3 Bypassed")->load() > 0.5f;
+	settings.peak4Bypassed = apvts.getRawParameterValue("Peak4 Bypassed")->load() > 0.5f;
+	settings.peak5Bypassed = apvts.getRawParameterValue("Peak5 Bypassed")->load() > 0.5f;
 
 	return settings;
 }
@@ -348,36 +1130,443 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
 void SimpleEQAudioProcessor::updateFilters()
 {
 	auto chainSettings = getChainSettings(apvts);
-
-	auto lowCutFreq = chainSettings.lowCutFreq;
-	bool isOff = low_cut_off_range.contains(lowCutFreq);
-
-	/*leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-	rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-	leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-	rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-	leftChain.setBypassed<ChainPositions::Peak1>(chainSettings.peak1Bypassed);
-	rightChain.setBypassed<ChainPositions::Peak1>(chainSettings.peak1Bypassed);*/
-
-	updateCutFilter<ChainPositions::LowCut>(
+	const auto mode = static_cast<ProcessingMode>(apvts.getRawParameterValue("Processing Mode")->load());
+	const auto bypassedPeaks = chainSettings.getBypassedPeaks();
+	const auto modulatedBands = modulation.getModulatedBands() & ~bypassedPeaks;
+	const auto suppression = apvts.getRawParameterValue("Resonance Suppression")->load() > 0.5f;
+
+	// Only the on/off switch changes what runs, the rest is cheap to set every time
+	resonanceSuppressor.setRange(chainSettings.lowCutFreq, chainSettings.highCutFreq);
+	resonanceSuppressor.setDepth(apvts.getRawParameterValue("Resonance Depth")->load());
+
+	outputGainDb = apvts.getRawParameterValue("Output Gain")->load();
+	const auto autoGain = apvts.getRawParameterValue("Auto Gain")->load() > 0.5f;
+	if (autoGain && !autoGainEnabled)
+	{
+		compensationDesignPending.store(true);
+		triggerAsyncUpdate();
+	}
+	autoGainEnabled = autoGain;
+
+	if (!filtersNeedUpdate && chainSettings == appliedSettings && mode == appliedMode && modulatedBands == appliedModulatedBands
+		&& suppression == appliedSuppression)
+		return;
+
+	// Only the cascade can fade a band back in, elsewhere the matrix lets go at once
+	if (activeMode != ProcessingMode::Cascade)
+		modulation.skipFades(modulatedBands, appliedModulatedBands & ~modulatedBands);
+
+	filtersNeedUpdate = false;
+	appliedSettings = chainSettings;
+	appliedMode = mode;
+	appliedModulatedBands = modulatedBands;
+	appliedSuppression = suppression;
+
+	// A bypassed cut is switched off, which the cut crossfades like a slope change
+	updateCutFilter(
+		leftLowCut,
+		rightLowCut,
 		chainSettings.lowCutFreq,
 		chainSettings.lowCutSlope,
 		lowCutButterworthMethod,
-		isOff);
+		chainSettings.isLowCutOff());
 
 	updatePeakFilter(chainSettings);
 
-	auto highCutFreq = chainSettings.highCutFreq;
-	isOff = high_cut_off_range.contains(highCutFreq);
+	updatePeakBand<ChainPositions::Peak1>((modulatedBands & (1 << 0)) != 0, (bypassedPeaks & (1 << 0)) != 0);
+	updatePeakBand<ChainPositions::Peak2>((modulatedBands & (1 << 1)) != 0, (bypassedPeaks & (1 << 1)) != 0);
+	updatePeakBand<ChainPositions::Peak3>((modulatedBands & (1 << 2)) != 0, (bypassedPeaks & (1 << 2)) != 0);
+	updatePeakBand<ChainPositions::Peak4>((modulatedBands & (1 << 3)) != 0, (bypassedPeaks & (1 << 3)) != 0);
+	updatePeakBand<ChainPositions::Peak5>((modulatedBands & (1 << 4)) != 0, (bypassedPeaks & (1 << 4)) != 0);
 
-	updateCutFilter<ChainPositions::HighCut>(
-		highCutFreq,
+	updateCutFilter(
+		leftHighCut,
+		rightHighCut,
+		chainSettings.highCutFreq,
 		chainSettings.highCutSlope,
 		highCutButterworthMethod,
-		isOff);
+		chainSettings.isHighCutOff());
+
+	updateRealisation(mode);
+
+	if (autoGainEnabled)
+	{
+		compensationDesignPending.store(true);
+		triggerAsyncUpdate();
+	}
+}
+
+void SimpleEQAudioProcessor::updateRealisation(ProcessingMode mode)
+{
+	auto realised = ProcessingMode::Cascade;
+	if (mode == ProcessingMode::Parallel && updateParallelFilters())
+		realised = ProcessingMode::Parallel;
+	else if (mode == ProcessingMode::BlockStateSpace)
+	{
+		updateBlockFilters();
+		realised = ProcessingMode::BlockStateSpace;
+	}
+	else if (mode == ProcessingMode::Stft)
+	{
+		stftExcludedBands.store(appliedModulatedBands);
+		stftDesignPending.store(true);
+		triggerAsyncUpdate();
+		realised = ProcessingMode::Stft;
+	}
+
+	if (realised != activeMode)
+	{
+		// Whichever realisation takes over starts from silence, not from stale state
+		switch (realised)
+		{
+			case ProcessingMode::Parallel:
+				leftParallel.reset();
+				rightParallel.reset();
+				break;
+
+			case ProcessingMode::BlockStateSpace:
+				leftBlockFilter.reset();
+				rightBlockFilter.reset();
+				break;
+
+			case ProcessingMode::Stft:
+				// Reset below, unless resonance suppression already has it running
+				break;
+
+			case ProcessingMode::Cascade:
+			default:
+				leftChain.reset();
+				rightChain.reset();
+				for (auto* cut : { &leftLowCut, &rightLowCut, &leftHighCut, &rightHighCut })
+					cut->reset();
+				break;
+		}
+
+		activeMode = realised;
+	}
+
+	const auto stftNeeded = activeMode == ProcessingMode::Stft || appliedSuppression;
+	if (stftNeeded && !stftActive)
+	{
+		stftEqualiser.reset();
+		resonanceSuppressor.reset();
+	}
+	stftActive = stftNeeded;
+
+	const auto latency = stftActive ? stftEqualiser.getLatencySamples() : 0;
+	if (latencyToReport.exchange(latency) != latency)
+		triggerAsyncUpdate();
+}
+
+void SimpleEQAudioProcessor::designSlot(AbSlot& slot, double sampleRate)
+{
+	// New objects every time. The chain may still hold the previous ones, so they
+	// mustn't change underneath it, and they're kept alive here so the audio
+	// thread never drops the last reference to them.
+	slot.retired.clear();
+	slot.retired.reserve(AbSlot::retiredCapacity);
+	for (auto* c : slot.lowCut)
+		slot.retired.push_back(c);
+	for (auto* c : slot.highCut)
+		slot.retired.push_back(c);
+	for (auto& c : slot.peaks)
+		slot.retired.push_back(c);
+
+	const auto& s = slot.settings;
+	slot.lowCut = makeCutFilter(s.lowCutFreq, sampleRate, s.lowCutSlope, lowCutButterworthMethod);
+	slot.highCut = makeCutFilter(s.highCutFreq, sampleRate, s.highCutSlope, highCutButterworthMethod);
+	slot.peaks =
+	{
+		makePeakFilter(s.peak1Freq, s.peak1Quality, s.peak1GainInDecibels, sampleRate),
+		makePeakFilter(s.peak2Freq, s.peak2Quality, s.peak2GainInDecibels, sampleRate),
+		makePeakFilter(s.peak3Freq, s.peak3Quality, s.peak3GainInDecibels, sampleRate),
+		makePeakFilter(s.peak4Freq, s.peak4Quality, s.peak4GainInDecibels, sampleRate),
+		makePeakFilter(s.peak5Freq, s.peak5Quality, s.peak5GainInDecibels, sampleRate)
+	};
+}
+
+void SimpleEQAudioProcessor::swapInSlot(AbSlot& slot)
+{
+	// Whatever the chains and the cut filters held until now is handed to the
+	// slot, into room designSlot() reserved, and released on the message thread
+	// when the slot is next designed
+	for (auto* chain : { &leftChain, &rightChain })
+	{
+		slot.retired.push_back(chain->get<ChainPositions::Peak1>().coefficients);
+		slot.retired.push_back(chain->get<ChainPositions::Peak2>().coefficients);
+		slot.retired.push_back(chain->get<ChainPositions::Peak3>().coefficients);
+		slot.retired.push_back(chain->get<ChainPositions::Peak4>().coefficients);
+		slot.retired.push_back(chain->get<ChainPositions::Peak5>().coefficients);
+
+		chain->get<ChainPositions::Peak1>().coefficients = slot.peaks[0];
+		chain->get<ChainPositions::Peak2>().coefficients = slot.peaks[1];
+		chain->get<ChainPositions::Peak3>().coefficients = slot.peaks[2];
+		chain->get<ChainPositions::Peak4>().coefficients = slot.peaks[3];
+		chain->get<ChainPositions::Peak5>().coefficients = slot.peaks[4];
+		chain->reset();
+	}
+
+	const auto& s = slot.settings;
+
+	leftLowCut.jumpTo(slot.lowCut, s.lowCutSlope, s.isLowCutOff(), slot.retired);
+	rightLowCut.jumpTo(slot.lowCut, s.lowCutSlope, s.isLowCutOff(), slot.retired);
+	leftHighCut.jumpTo(slot.highCut, s.highCutSlope, s.isHighCutOff(), slot.retired);
+	rightHighCut.jumpTo(slot.highCut, s.highCutSlope, s.isHighCutOff(), slot.retired);
+	jassert(slot.retired.size() <= AbSlot::retiredCapacity);
+
+	// The output is silent here, so bypassed bands leave the chain without a fade
+	const auto bypassedPeaks = s.getBypassedPeaks();
+	appliedModulatedBands &= ~bypassedPeaks;
+	updatePeakBand<ChainPositions::Peak1>((appliedModulatedBands & (1 << 0)) != 0, (bypassedPeaks & (1 << 0)) != 0);
+	updatePeakBand<ChainPositions::Peak2>((appliedModulatedBands & (1 << 1)) != 0, (bypassedPeaks & (1 << 1)) != 0);
+	updatePeakBand<ChainPositions::Peak3>((appliedModulatedBands & (1 << 2)) != 0, (bypassedPeaks & (1 << 2)) != 0);
+	updatePeakBand<ChainPositions::Peak4>((appliedModulatedBands & (1 << 3)) != 0, (bypassedPeaks & (1 << 3)) != 0);
+	updatePeakBand<ChainPositions::Peak5>((appliedModulatedBands & (1 << 4)) != 0, (bypassedPeaks & (1 << 4)) != 0);
+	for (auto& wet : peakWet)
+		wet.setCurrentAndTargetValue(wet.getTargetValue());
+	modulation.skipFades(appliedModulatedBands);
+	retirePeakBandIfFaded<ChainPositions::Peak1>();
+	retirePeakBandIfFaded<ChainPositions::Peak2>();
+	retirePeakBandIfFaded<ChainPositions::Peak3>();
+	retirePeakBandIfFaded<ChainPositions::Peak4>();
+	retirePeakBandIfFaded<ChainPositions::Peak5>();
+
+	appliedSettings = s;
+	updateRealisation(appliedMode);
+
+	for (auto* realisation : { &leftParallel, &rightParallel })
+		realisation->reset();
+	for (auto* realisation : { &leftBlockFilter, &rightBlockFilter })
+		realisation->reset();
+}
+
+void SimpleEQAudioProcessor::swapOutCascade()
+{
+	// Moves, so the outgoing side keeps its state and nothing is allocated.
+	// The live side gets whatever the last switch left behind, and
+	// swapInSlot() retires its coefficients before pointing it at the slot.
+	std::swap(leftChain, abOutgoing.leftChain);
+	std::swap(rightChain, abOutgoing.rightChain);
+	std::swap(leftLowCut, abOutgoing.leftLowCut);
+	std::swap(rightLowCut, abOutgoing.rightLowCut);
+	std::swap(leftHighCut, abOutgoing.leftHighCut);
+	std::swap(rightHighCut, abOutgoing.rightHighCut);
 }
 
-template<int Index> void SimpleEQAudioProcessor::updateCutFilter(
+void SimpleEQAudioProcessor::crossfadeFromOutgoing(float* left, float* right, int numSamples) noexcept
+{
+	auto* outgoingLeft = abOutgoing.buffer.getWritePointer(0);
+	auto* outgoingRight = abOutgoing.buffer.getWritePointer(1);
+
+	// The outgoing bands run whole, even one that was fading out
+	for (auto [chain, lowCut, highCut, data] : {
+		std::tuple<MonoChain*, CrossfadingCut*, CrossfadingCut*, float*>{ &abOutgoing.leftChain, &abOutgoing.leftLowCut, &abOutgoing.leftHighCut, outgoingLeft },
+		std::tuple<MonoChain*, CrossfadingCut*, CrossfadingCut*, float*>{ &abOutgoing.rightChain, &abOutgoing.rightLowCut, &abOutgoing.rightHighCut, outgoingRight } })
+	{
+		lowCut->process(data, numSamples);
+		juce::dsp::AudioBlock<float> block(&data, 1, static_cast<size_t>(numSamples));
+		juce::dsp::ProcessContextReplacing<float> context(block);
+		chain->process(context);
+		highCut->process(data, numSamples);
+	}
+
+	// The same input went through both slots, so a linear crossfade holds the level
+	for (int i = 0; i < numSamples; ++i)
+	{
+		const auto position = abCrossfade.getNextValue();
+		left[i] = outgoingLeft[i] + position * (left[i] - outgoingLeft[i]);
+		right[i] = outgoingRight[i] + position * (right[i] - outgoingRight[i]);
+	}
+}
+
+void SimpleEQAudioProcessor::toggleAB()
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+
+	if (pendingSlot.load() >= 0 || getSampleRate() <= 0.0)
+		return;
+
+	const auto current = activeSlot.load();
+	const auto next = 1 - current;
+
+	// The slot being left is kept ready for the way back
+	auto& outgoing = abSlots[static_cast<size_t>(current)];
+	outgoing.settings = getChainSettings(apvts);
+	designSlot(outgoing, getSampleRate());
+
+	abParametersSyncing.store(true);
+	pendingSlot.store(next);
+
+	const auto& s = abSlots[static_cast<size_t>(next)].settings;
+	// Each change is its own gesture, so hosts record it like a user's edit
+	auto set = [this](const juce::String& id, float value)
+	{
+		if (auto* parameter = apvts.getParameter(id))
+		{
+			parameter->beginChangeGesture();
+			parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+			parameter->endChangeGesture();
+		}
+	};
+
+	set("LowCut Freq", s.lowCutFreq);
+	set("LowCut Slope", static_cast<float>(s.lowCutSlope));
+	set("HighCut Freq", s.highCutFreq);
+	set("HighCut Slope", static_cast<float>(s.highCutSlope));
+	set("Peak1 Freq", s.peak1Freq);
+	set("Peak1 Gain", s.peak1GainInDecibels);
+	set("Peak1 Quality", s.peak1Quality);
+	set("Peak2 Freq", s.peak2Freq);
+	set("Peak2 Gain", s.peak2GainInDecibels);
+	set("Peak2 Quality", s.peak2Quality);
+	set("Peak3 Freq", s.peak3Freq);
+	set("Peak3 Gain", s.peak3GainInDecibels);
+	set("Peak3 Quality", s.peak3Quality);
+	set("Peak4 Freq", s.peak4Freq);
+	set("Peak4 Gain", s.peak4GainInDecibels);
+	set("Peak4 Quality", s.peak4Quality);
+	set("Peak5 Freq", s.peak5Freq);
+	set("Peak5 Gain", s.peak5GainInDecibels);
+	set("Peak5 Quality", s.peak5Quality);
+	set("LowCut Bypassed", s.lowCutBypassed ? 1.f : 0.f);
+	set("HighCut Bypassed", s.highCutBypassed ? 1.f : 0.f);
+	set("Peak1 Bypassed", s.peak1Bypassed ? 1.f : 0.f);
+	set("Peak2 Bypassed", s.peak2Bypassed ? 1.f : 0.f);
+	set("Peak3 Bypassed", s.peak3Bypassed ? 1.f : 0.f);
+	set("Peak4 Bypassed", s.peak4Bypassed ? 1.f : 0.f);
+	set("Peak5 Bypassed", s.peak5Bypassed ? 1.f : 0.f);
+
+	abParametersSyncing.store(false);
+}
+
+int getActiveSections(const CutFilter& lowCut, const MonoChain& chain, const CutFilter& highCut, CascadeSections& sections)
+{
+	int numSections = 0;
+	auto add = [&](const Filter& filter)
+	{
+		if (numSections < static_cast<int>(sections.size()))
+			sections[static_cast<size_t>(numSections++)] = filter.coefficients.get();
+	};
+
+	forEachActiveStage(lowCut, add, std::make_index_sequence<NUM_FILTER_SLOPES>());
+	forEachActiveStage(chain, add, std::index_sequence<ChainPositions::Peak1, ChainPositions::Peak2,
+		ChainPositions::Peak3, ChainPositions::Peak4, ChainPositions::Peak5>());
+	forEachActiveStage(highCut, add, std::make_index_sequence<NUM_FILTER_SLOPES>());
+
+	return numSections;
+}
+
+bool SimpleEQAudioProcessor::updateParallelFilters()
+{
+	CascadeSections sections;
+	const auto numSections = getActiveSections(leftLowCut.getCurrent(), leftChain, leftHighCut.getCurrent(), sections);
+
+	if (!parallelDesign.expand(sections.data(), numSections))
+		return false;
+
+	leftParallel.setDesign(parallelDesign);
+	rightParallel.setDesign(parallelDesign);
+	return true;
+}
+
+void SimpleEQAudioProcessor::updateBlockFilters()
+{
+	CascadeSections sections;
+	const auto numSections = getActiveSections(leftLowCut.getCurrent(), leftChain, leftHighCut.getCurrent(), sections);
+
+	leftBlockFilter.setSections(sections.data(), numSections);
+	rightBlockFilter.setSections(sections.data(), numSections);
+}
+
+template<int Index> void SimpleEQAudioProcessor::updatePeakBand(bool isModulated, bool isBypassed)
+{
+	auto& wet = peakWet[static_cast<size_t>(Index - ChainPositions::Peak1)];
+	const auto target = isModulated || isBypassed ? 0.f : 1.f;
+
+	// The cascade fades a band out while the matrix fades it in. The other
+	// realisations can't, so they hand it over at once and the matrix's fade
+	// in is heard as the band easing in.
+	if (isModulated && activeMode != ProcessingMode::Cascade)
+		wet.setCurrentAndTargetValue(target);
+	else
+		wet.setTargetValue(target);
+
+	// A band being bypassed or handed to the matrix stays in until it has faded out
+	const auto inChain = target > 0.f || wet.getCurrentValue() > 0.f;
+
+	// A band coming back would otherwise resume from the state it had when it left
+	if (inChain && leftChain.isBypassed<Index>())
+	{
+		leftChain.get<Index>().reset();
+		rightChain.get<Index>().reset();
+	}
+
+	leftChain.setBypassed<Index>(!inChain);
+	rightChain.setBypassed<Index>(!inChain);
+}
+
+template<int Index> void SimpleEQAudioProcessor::processPeakBand(float* left, float* right, int numSamples) noexcept
+{
+	if (leftChain.isBypassed<Index>())
+		return;
+
+	auto run = [](Filter& filter, float* data, int num)
+	{
+		juce::dsp::AudioBlock<float> block(&data, 1, static_cast<size_t>(num));
+		juce::dsp::ProcessContextReplacing<float> context(block);
+		filter.process(context);
+	};
+
+	auto& wet = peakWet[static_cast<size_t>(Index - ChainPositions::Peak1)];
+
+	if (!wet.isSmoothing())
+	{
+		run(leftChain.get<Index>(), left, numSamples);
+		run(rightChain.get<Index>(), right, numSamples);
+		return;
+	}
+
+	auto* ramp = peakFadeScratch.getWritePointer(0);
+	auto* dry = peakFadeScratch.getWritePointer(1);
+	const auto scratchSize = peakFadeScratch.getNumSamples();
+
+	for (int start = 0; start < numSamples; start += scratchSize)
+	{
+		const auto num = juce::jmin(scratchSize, numSamples - start);
+
+		for (int i = 0; i < num; ++i)
+			ramp[i] = wet.getNextValue();
+
+		for (auto [filter, data] : { std::pair<Filter*, float*>{ &leftChain.get<Index>(), left + start },
+									 std::pair<Filter*, float*>{ &rightChain.get<Index>(), right + start } })
+		{
+			// data = dry + ramp * (filtered - dry)
+			juce::FloatVectorOperations::copy(dry, data, num);
+			run(*filter, data, num);
+			juce::FloatVectorOperations::subtract(data, dry, num);
+			juce::FloatVectorOperations::multiply(data, ramp, num);
+			juce::FloatVectorOperations::add(data, dry, num);
+		}
+	}
+}
+
+template<int Index> void SimpleEQAudioProcessor::retirePeakBandIfFaded()
+{
+	const auto& wet = peakWet[static_cast<size_t>(Index - ChainPositions::Peak1)];
+	if (leftChain.isBypassed<Index>() || wet.isSmoothing() || wet.getTargetValue() > 0.f)
+		return;
+
+	leftChain.setBypassed<Index>(true);
+	rightChain.setBypassed<Index>(true);
+
+	// The parallel and block realisations are designed from the chain's active stages
+	if (activeMode != ProcessingMode::Cascade)
+		filtersNeedUpdate = true;
+}
+
+void SimpleEQAudioProcessor::updateCutFilter(
+	CrossfadingCut& leftCut,
+	CrossfadingCut& rightCut,
 	const float cutFreq,
 	const Slope slope,
 	CoefficientRefArray(*filterDesignMethod)(float, double, int),
@@ -385,11 +1574,120 @@ template<int Index> void SimpleEQAudioProcessor::updateCutFilter(
 {
 	auto cutCoefficients = makeCutFilter(cutFreq, getSampleRate(), slope, filterDesignMethod);
 
-	auto& leftCut = leftChain.get<Index>();
-	auto& rightCut = rightChain.get<Index>();
+	leftCut.setCoefficients(cutCoefficients, slope, isOff);
+	rightCut.setCoefficients(cutCoefficients, slope, isOff);
+}
+
+void CrossfadingCut::prepare(const juce::dsp::ProcessSpec& spec)
+{
+	for (auto& filter : filters)
+		filter.prepare(spec);
 
-	applyCoefficientsToCutFilter(leftCut, cutCoefficients, slope, isOff);
-	applyCoefficientsToCutFilter(rightCut, cutCoefficients, slope, isOff);
+	scratch.setSize(1, static_cast<int>(spec.maximumBlockSize), false, true, false);
+	fadeLength = juce::jmax(1, juce::roundToInt(spec.sampleRate * crossfadeSeconds));
+	reset();
+}
+
+void CrossfadingCut::reset()
+{
+	// A pending crossfade is finished at once
+	live = getCurrentIndex();
+	fadeRemaining = 0;
+
+	for (auto& filter : filters)
+		filter.reset();
+}
+
+void CrossfadingCut::setCoefficients(const CoefficientRefArray& coefficients, Slope slope, bool isOff)
+{
+	const auto current = static_cast<size_t>(getCurrentIndex());
+
+	if (slope == slopes[current] && isOff == offStates[current])
+	{
+		applyCoefficientsToCutFilter(filters[current], coefficients, slope, isOff);
+		return;
+	}
+
+	// A change during a crossfade jumps to the filter being faded to and fades on from there
+	live = static_cast<int>(current);
+
+	const auto incoming = static_cast<size_t>(1 - live);
+	filters[incoming].reset();
+	applyCoefficientsToCutFilter(filters[incoming], coefficients, slope, isOff);
+	slopes[incoming] = slope;
+	offStates[incoming] = isOff;
+	fadeRemaining = fadeLength;
+}
+
+template<size_t... Index>
+void pointCutFilterAt(CutFilter& cut, const CoefficientRefArray& coefficients, Slope slope, bool isOff, std::index_sequence<Index...>)
+{
+	// Stage i runs for slopes of (i + 1) * 12 dB/Oct and steeper
+	(cut.template setBypassed<Index>(isOff || static_cast<int>(Index) > slope), ...);
+	((isOff || static_cast<int>(Index) > slope ? void() : void(cut.template get<Index>().coefficients = coefficients[static_cast<int>(Index)])), ...);
+}
+
+template<size_t... Index>
+void retireCutFilterStages(CutFilter& cut, Slope slope, bool isOff, std::vector<Coefficients>& retired, std::index_sequence<Index...>)
+{
+	// The stages pointCutFilterAt is about to repoint
+	((isOff || static_cast<int>(Index) > slope ? void() : retired.push_back(cut.template get<Index>().coefficients)), ...);
+}
+
+void CrossfadingCut::jumpTo(const CoefficientRefArray& coefficients, Slope slope, bool isOff, std::vector<Coefficients>& retired)
+{
+	reset();
+
+	// The stages take the designed objects themselves rather than copies of them
+	auto& filter = filters[static_cast<size_t>(live)];
+	retireCutFilterStages(filter, slope, isOff, retired, std::make_index_sequence<NUM_FILTER_SLOPES>());
+	pointCutFilterAt(filter, coefficients, slope, isOff, std::make_index_sequence<NUM_FILTER_SLOPES>());
+	slopes[static_cast<size_t>(live)] = slope;
+	offStates[static_cast<size_t>(live)] = isOff;
+}
+
+void CrossfadingCut::process(float* samples, int numSamples) noexcept
+{
+	auto run = [](CutFilter& filter, float* data, int num)
+	{
+		juce::dsp::AudioBlock<float> block(&data, 1, static_cast<size_t>(num));
+		juce::dsp::ProcessContextReplacing<float> context(block);
+		filter.process(context);
+	};
+
+	auto& outgoing = filters[static_cast<size_t>(live)];
+
+	if (fadeRemaining == 0)
+	{
+		run(outgoing, samples, numSamples);
+		return;
+	}
+
+	auto& incoming = filters[static_cast<size_t>(1 - live)];
+	auto* faded = scratch.getWritePointer(0);
+	const auto scratchSize = scratch.getNumSamples();
+
+	for (int start = 0; start < numSamples; start += scratchSize)
+	{
+		const auto num = juce::jmin(scratchSize, numSamples - start);
+		auto* data = samples + start;
+
+		juce::FloatVectorOperations::copy(faded, data, num);
+		run(outgoing, data, num);
+		run(incoming, faded, num);
+
+		// Both paths filter the same input, so a linear crossfade keeps the level
+		for (int i = 0; i < num; ++i)
+		{
+			const auto position = juce::jmin(1.f, static_cast<float>(fadeLength - fadeRemaining + i + 1) / fadeLength);
+			data[i] += position * (faded[i] - data[i]);
+		}
+
+		fadeRemaining = juce::jmax(0, fadeRemaining - num);
+	}
+
+	if (fadeRemaining == 0)
+		live = 1 - live;
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::createParameterLayout()
@@ -515,10 +1813,31 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
 	layout.add(std::make_unique<juce::AudioParameterChoice>(
 		"HighCut Slope", "HighCut Slope", filterSlopeValues, 0));
 
-	/*layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypassed", "LowCut Bypassed", false));
-	layout.add(std::make_unique<juce::AudioParameterBool>("Peak Bypassed", "Peak Bypassed", false));
+	layout.add(std::make_unique<juce::AudioParameterChoice>(
+		"Analyzer Mode", "Analyzer Mode", juce::StringArray{ "Post", "Pre/Post" }, 0));
+
+	layout.add(std::make_unique<juce::AudioParameterChoice>(
+		"Processing Mode", "Processing Mode", juce::StringArray{ "Cascade", "Parallel", "Block State-Space", "STFT" }, 0));
+
+	ModulationMatrix::addParameters(layout);
+
+	layout.add(std::make_unique<juce::AudioParameterBool>("LowCut Bypassed", "LowCut Bypassed", false));
+	for (int i = 1; i <= 5; ++i)
+	{
+		const auto name = "Peak" + juce::String(i) + " Bypassed";
+		layout.add(std::make_unique<juce::AudioParameterBool>(name, name, false));
+	}
 	layout.add(std::make_unique<juce::AudioParameterBool>("HighCut Bypassed", "High Cut Bypassed", false));
-	layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Bypassed", "Analyzer Bypassed", true));*/
+	layout.add(std::make_unique<juce::AudioParameterBool>("Analyzer Bypassed", "Analyzer Bypassed", false));
+	layout.add(std::make_unique<juce::AudioParameterBool>("Bypass", "Bypass", false));
+
+	layout.add(std::make_unique<juce::AudioParameterFloat>(
+		"Output Gain", "Output Gain", juce::NormalisableRange<float>(-24.f, 24.f, 0.1f, 1.f), 0.f));
+	layout.add(std::make_unique<juce::AudioParameterBool>("Auto Gain", "Auto Gain", false));
+
+	layout.add(std::make_unique<juce::AudioParameterBool>("Resonance Suppression", "Resonance Suppression", false));
+	layout.add(std::make_unique<juce::AudioParameterFloat>(
+		"Resonance Depth", "Resonance Depth", juce::NormalisableRange<float>(0.f, 24.f, 0.5f, 1.f), 9.f));
 
 	return layout;
 }
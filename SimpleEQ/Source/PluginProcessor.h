@@ -16,34 +16,64 @@ Roadmap
 
 #include <JuceHeader.h>
 #include <array>
+#include <tuple>
+#include <utility>
+#include "DeferredPreparation.h"
+#include "FastCoefficientDesign.h"
+#include "FrameScheduler.h"
+#include "GainCompensation.h"
+#include "LoadGovernor.h"
+#include "LoudnessMeter.h"
+#include "TruePeakMeter.h"
+#include "ParallelIIR.h"
+#include "BlockStateSpaceIIR.h"
+#include "Modulation.h"
+#include "SignalHealth.h"
+#include "StftEqualiser.h"
+#include "WorkerPool.h"
+#include "SpectrumAnalyser.h"
+#include "Spectrogram.h"
+#include "ResponseCurvePlot.h"
+
+#if SIMPLEEQ_BUILD_CLAP
+#include <clap-juce-extensions/clap-juce-extensions.h>
+#endif
 
 const auto low_cut_off_range = juce::Range<float>(0, 6);
 const auto high_cut_off_range = juce::Range<float>(21500, 22001);
 static float maxLevel = 24.0f;
 
+// The analyzer FIFOs are sized in time rather than in host blocks, so an instance
+// costs the same whether the host runs 32 or 8192 sample blocks.
+const float analyzer_fifo_length_ms = 200.f;
+const int analyzer_fifo_slot_size = 512;
+
 template<typename T>
 struct Fifo
 {
-	void prepare(int numChannels, int numSamples)
+	void prepare(int numSlots, int numChannels, int numSamples)
 	{
 		static_assert(std::is_same_v<T, juce::AudioBuffer<float>>,
-			"prepare(numChannels, numSamples) should only be used on Fifo<AudioBuffer<float>> ");
+			"prepare(numSlots, numChannels, numSamples) should only be used on Fifo<AudioBuffer<float>> ");
+		setCapacity(numSlots);
 		for (auto& buffer : buffers)
 		{
 			buffer.setSize(
 				numChannels,
+				numSamples,
 				false,
 				true,
-				true
+				false
 			);
 			buffer.clear();
 		}
 	}
 
-	void prepare(size_t numElements)
+	void prepare(int numSlots, size_t numElements)
 	{
 		static_assert(std::is_same_v<T, std::vector<float>>,
-			"prepare(numElements) should only be used on Fifo<std::vector<float>>");
+			"prepare(numSlots, numElements) should only be used on Fifo<std::vector<float>>");
+		setCapacity(numSlots);
 		for (auto& buffer : buffers)
 		{
 			buffer.clear();
@@ -77,10 +107,32 @@ struct Fifo
 	{
 		return fifo.getNumReady();
 	}
+
+	int getCapacity() const { return static_cast<int>(buffers.size()); }
+
+	size_t getMemoryUsageInBytes() const
+	{
+		size_t bytes = 0;
+		for (const auto& buffer : buffers)
+		{
+			if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+				bytes += sizeof(float) * static_cast<size_t>(buffer.getNumChannels() * buffer.getNumSamples());
+			else
+				bytes += sizeof(float) * buffer.capacity();
+		}
+		return bytes;
+	}
 private:
-	static constexpr int Capacity = 30;
-	std::array<T, Capacity> buffers;
-	juce::AbstractFifo fifo{ Capacity };
+	void setCapacity(int numSlots)
+	{
+		// AbstractFifo keeps one slot free, so a capacity of 2 holds a single buffer
+		numSlots = juce::jmax(2, numSlots);
+		std::vector<T>(static_cast<size_t>(numSlots)).swap(buffers);
+		fifo.setTotalSize(numSlots);
+	}
+
+	std::vector<T> buffers;
+	juce::AbstractFifo fifo{ 2 };
 };
 
 enum Channel
@@ -109,14 +161,17 @@ struct SingleChannelSampleFifo
 		}
 	}
 
-	void prepare(int bufferSize)
+	void prepare(double sampleRate, float lengthInMs = analyzer_fifo_length_ms)
 	{
 		prepared.set(false);
-		size.set(bufferSize);
+		size.set(analyzer_fifo_slot_size);
+
+		bufferToFill.setSize(1, analyzer_fifo_slot_size, false, true, false);
 
-		bufferToFill.setSize(1, bufferSize, false, true, true);
+		auto lengthInSamples = sampleRate * lengthInMs / 1000.0;
+		auto numSlots = static_cast<int>(std::ceil(lengthInSamples / analyzer_fifo_slot_size)) + 1;
 
-		audioBufferFifo.prepare(1, bufferSize);
+		audioBufferFifo.prepare(numSlots, 1, analyzer_fifo_slot_size);
 		fifoIndex = 0;
 		prepared.set(true);
 	}
@@ -125,6 +180,12 @@ struct SingleChannelSampleFifo
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
 
+	size_t getMemoryUsageInBytes() const
+	{
+		return audioBufferFifo.getMemoryUsageInBytes()
+			+ sizeof(float) * static_cast<size_t>(bufferToFill.getNumSamples());
+	}
+
 	bool getAudioBuffer(BlockType& buffer) { return audioBufferFifo.pull(buffer); }
 private:
 	Channel channelToUse;
@@ -149,6 +210,84 @@ private:
 	}
 };
 
+// Holds the most recent output while the editor is hidden, so the analyzer can be
+// primed with it when the editor comes back instead of filling up from silence.
+const float analyzer_warmup_ms = 100.f;
+
+struct AnalyzerWarmupBuffer
+{
+	void prepare(int numChannels, double sampleRate)
+	{
+		auto numSamples = juce::jmax(1, juce::roundToInt(sampleRate * analyzer_warmup_ms / 1000.0));
+
+		ring.setSize(numChannels, numSamples, false, true, false);
+		history.setSize(numChannels, numSamples, false, true, false);
+		reset();
+	}
+
+	void reset()
+	{
+		ring.clear();
+		writeIndex = 0;
+		numBuffered = 0;
+	}
+
+	void push(const juce::AudioBuffer<float>& buffer)
+	{
+		const auto size = ring.getNumSamples();
+		const auto numChannels = juce::jmin(ring.getNumChannels(), buffer.getNumChannels());
+		auto numSamples = buffer.getNumSamples();
+		auto sourceStart = 0;
+
+		if (numSamples > size)
+		{
+			sourceStart = numSamples - size;
+			numSamples = size;
+		}
+
+		const auto first = juce::jmin(numSamples, size - writeIndex);
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			ring.copyFrom(ch, writeIndex, buffer, ch, sourceStart, first);
+			if (numSamples > first)
+				ring.copyFrom(ch, 0, buffer, ch, sourceStart + first, numSamples - first);
+		}
+
+		writeIndex = (writeIndex + numSamples) % size;
+		numBuffered = juce::jmin(size, numBuffered + numSamples);
+	}
+
+	bool isEmpty() const { return numBuffered == 0; }
+
+	// Unwraps the ring oldest sample first. Doesn't allocate.
+	const juce::AudioBuffer<float>& getHistory()
+	{
+		const auto size = ring.getNumSamples();
+		const auto start = (writeIndex - numBuffered + size) % size;
+		const auto first = juce::jmin(numBuffered, size - start);
+
+		history.setSize(ring.getNumChannels(), numBuffered, false, false, true);
+		for (int ch = 0; ch < ring.getNumChannels(); ++ch)
+		{
+			history.copyFrom(ch, 0, ring, ch, start, first);
+			if (numBuffered > first)
+				history.copyFrom(ch, first, ring, ch, 0, numBuffered - first);
+		}
+
+		return history;
+	}
+
+	size_t getMemoryUsageInBytes() const
+	{
+		return 2 * sizeof(float) * static_cast<size_t>(ring.getNumChannels() * ring.getNumSamples());
+	}
+
+private:
+	juce::AudioBuffer<float> ring, history;
+	int writeIndex = 0;
+	int numBuffered = 0;
+};
+
 // NUM_FILTER_SLOPES == num entries in Slope == num filters in CutFilter
 const int NUM_FILTER_SLOPES = 8;
 enum Slope
@@ -172,6 +311,35 @@ struct ChainSettings
 	float peak5Freq{ 0 }, peak5GainInDecibels{ 0 }, peak5Quality{ 1.f };
 	float lowCutFreq{ 0 }, highCutFreq{ 0 };
 	Slope lowCutSlope{ Slope_12 }, highCutSlope{ Slope_12 };
+	bool lowCutBypassed{ false }, highCutBypassed{ false };
+	bool peak1Bypassed{ false }, peak2Bypassed{ false }, peak3Bypassed{ false }, peak4Bypassed{ false }, peak5Bypassed{ false };
+
+	auto tie() const
+	{
+		return std::tie(
+			peak1Freq, peak1GainInDecibels, peak1Quality,
+			peak2Freq, peak2GainInDecibels, peak2Quality,
+			peak3Freq, peak3GainInDecibels, peak3Quality,
+			peak4Freq, peak4GainInDecibels, peak4Quality,
+			peak5Freq, peak5GainInDecibels, peak5Quality,
+			lowCutFreq, highCutFreq,
+			lowCutSlope, highCutSlope,
+			lowCutBypassed, highCutBypassed,
+			peak1Bypassed, peak2Bypassed, peak3Bypassed, peak4Bypassed, peak5Bypassed);
+	}
+
+	// One bit per peak, laid out like ModulationMatrix::getModulatedBands
+	int getBypassedPeaks() const
+	{
+		return (peak1Bypassed ? 1 << 0 : 0) | (peak2Bypassed ? 1 << 1 : 0) | (peak3Bypassed ? 1 << 2 : 0)
+			| (peak4Bypassed ? 1 << 3 : 0) | (peak5Bypassed ? 1 << 4 : 0);
+	}
+
+	bool isLowCutOff() const { return lowCutBypassed || low_cut_off_range.contains(lowCutFreq); }
+	bool isHighCutOff() const { return highCutBypassed || high_cut_off_range.contains(highCutFreq); }
+
+	bool operator==(const ChainSettings& other) const { return tie() == other.tie(); }
+	bool operator!=(const ChainSettings& other) const { return tie() != other.tie(); }
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
@@ -187,6 +355,20 @@ enum ChainPositions
 	HighCut
 };
 
+// How the cuts and peaks are realised. The first three give the same response,
+// Stft gives the same magnitude with linear phase and a frame of latency.
+// Only Cascade fades a single band in or out when it is bypassed or handed to
+// the modulation matrix. Parallel and BlockStateSpace are redesigned as a whole,
+// so the band comes or goes at once where its fade would end. Stft takes the
+// new curve at the next frame, and overlap-add blends it in over a frame.
+enum class ProcessingMode
+{
+	Cascade,
+	Parallel,
+	BlockStateSpace,
+	Stft
+};
+
 using Filter = juce::dsp::IIR::Filter<float>;
 
 using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter, Filter, Filter, Filter, Filter>;
@@ -269,6 +451,22 @@ void applyCoefficientsToCutFilter(
 	}
 }
 
+template<typename ChainType, typename Function, size_t... Index>
+void forEachActiveStage(const ChainType& chain, Function&& fn, std::index_sequence<Index...>)
+{
+	((chain.template isBypassed<Index>() ? void() : fn(chain.template get<Index>())), ...);
+}
+
+using CascadeSections = std::array<const juce::dsp::IIR::Coefficients<float>*, ParallelIIRDesign::maxSections>;
+
+// Collects the coefficients of every stage the chain runs, in processing order
+int getActiveSections(const CutFilter& lowCut, const MonoChain& chain, const CutFilter& highCut, CascadeSections& sections);
+
+inline int getActiveSections(const MonoChain& chain, CascadeSections& sections)
+{
+	return getActiveSections(chain.get<ChainPositions::LowCut>(), chain, chain.get<ChainPositions::HighCut>(), sections);
+}
+
 inline auto makeCutFilter(
 	const float cutFreq,
 	double sampleRate,
@@ -278,10 +476,54 @@ inline auto makeCutFilter(
 	return filterDesignMethod(cutFreq, sampleRate, (2 * (slope + 1)));
 }
 
+// Every section the settings call for, in processing order, leaving out the
+// peaks set in excludedPeaks. Designed afresh, so any thread can call it.
+std::vector<Coefficients> makeChainSections(const ChainSettings& settings, double sampleRate, int excludedPeaks);
+
+// A cut filter that changes slope without clicking. Changing the slope
+// re-designs every stage, so the stage states no longer fit. The new slope is
+// therefore designed into a spare filter that starts from silence. Both run
+// side by side for a short crossfade, then the spare becomes the live filter.
+// Frequency changes go straight to the filter in use, as they always have. Outside a
+// crossfade only one filter runs, at the same cost as a CutFilter in the chain.
+class CrossfadingCut
+{
+public:
+	void prepare(const juce::dsp::ProcessSpec& spec);
+	void reset();
+
+	void setCoefficients(const CoefficientRefArray& coefficients, Slope slope, bool isOff);
+
+	// Switches with no crossfade and from silence, for when the output has been faded out.
+	// The objects the replaced stages held go to retired instead of being released here.
+	void jumpTo(const CoefficientRefArray& coefficients, Slope slope, bool isOff, std::vector<Coefficients>& retired);
+	void process(float* samples, int numSamples) noexcept;
+
+	// The filter that matches the latest settings, the one being faded to if a crossfade is running
+	const CutFilter& getCurrent() const noexcept { return filters[static_cast<size_t>(getCurrentIndex())]; }
+
+	static constexpr double crossfadeSeconds = 0.02;
+
+private:
+	int getCurrentIndex() const noexcept { return fadeRemaining > 0 ? 1 - live : live; }
+
+	std::array<CutFilter, 2> filters;
+	std::array<Slope, 2> slopes{ Slope_12, Slope_12 };
+	std::array<bool, 2> offStates{ true, true };
+	int live = 0;
+	int fadeLength = 1;
+	int fadeRemaining = 0;
+	juce::AudioBuffer<float> scratch;
+};
+
 //==============================================================================
 /**
 */
-class SimpleEQAudioProcessor : public foleys::MagicProcessor, private juce::AsyncUpdater
+class SimpleEQAudioProcessor : public foleys::MagicProcessor, private juce::AsyncUpdater, private FrameScheduler::Monitor,
+	private juce::AudioProcessorValueTreeState::Listener
+#if SIMPLEEQ_BUILD_CLAP
+	, public clap_juce_extensions::clap_juce_audio_processor_capabilities, private juce::AudioProcessorParameter::Listener
+#endif
 #if JucePlugin_Enable_ARA
 	, public juce::AudioProcessorARAExtension
 #endif
@@ -309,6 +551,9 @@ public:
 
 	void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
+	// The "Bypass" parameter, so hosts switch it rather than calling processBlockBypassed
+	juce::AudioProcessorParameter* getBypassParameter() const override;
+
 	//==============================================================================
 	const juce::String getName() const override;
 
@@ -325,6 +570,21 @@ public:
 	void changeProgramName(int index, const juce::String& newName) override;
 
 	void handleAsyncUpdate() override;
+	void monitorTick() override;
+	void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+#if SIMPLEEQ_BUILD_CLAP
+	// Runs the whole CLAP process call, splitting the block at each parameter
+	// event so automation lands on the sample it was written for. This replaces
+	// the extensions' own process, so edits made in the editor are sent to the
+	// host from here too, and from the flush the host calls while not processing.
+	bool supportsDirectProcess() override { return true; }
+	clap_process_status clap_direct_process(const clap_process* process) noexcept override;
+	bool supportsDirectParamsFlush() override { return true; }
+	void clap_direct_paramsFlush(const clap_input_events* in, const clap_output_events* out) noexcept override;
+#endif
+
+	void initialiseBuilder(foleys::MagicGUIBuilder& builder) override;
 
 	////==============================================================================
 	//void getStateInformation(juce::MemoryBlock& destData) override;
@@ -336,6 +596,29 @@ public:
 	using BlockType = juce::AudioBuffer<float>;
 	SingleChannelSampleFifo<BlockType> leftChannelFifo{ Channel::Left };
 	SingleChannelSampleFifo<BlockType> rightChannelFifo{ Channel::Right };
+	SingleChannelSampleFifo<BlockType> leftPreEqFifo{ Channel::Left };
+	SingleChannelSampleFifo<BlockType> rightPreEqFifo{ Channel::Right };
+
+	// True once the work prepareToPlay hands to the worker pool has finished
+	bool isAnalyzerReady() const noexcept { return preparation.isReady(); }
+	size_t getAnalyzerMemoryUsageInBytes() const;
+	double getLastInstanceReadyTimeMs() const { return preparation.getLastReadyTimeMs(); }
+	int getQualityTier() const { return loadGovernor.getCurrentTier(); }
+	int getNumHealthResets() const { return healthResets.load(); }
+
+	// BS.1770 loudness of the output in LUFS, from any thread
+	float getMomentaryLoudness() const { return loudnessMeter.getMomentary(); }
+	float getShortTermLoudness() const { return loudnessMeter.getShortTerm(); }
+	float getIntegratedLoudness() const { return loudnessMeter.getIntegrated(); }
+	juce::String getLoudnessReport() const { return loudnessMeter.getReport(); }
+
+	// The highest 4x oversampled peak of each output channel, in dBTP
+	float getTruePeakDb(int channel) const { return truePeakMeter.getTruePeakDb(channel); }
+	juce::String getTruePeakReport() const { return truePeakMeter.getReport(); }
+
+	// Starts both meters again, from the next block
+	void resetMeters() { metersResetPending.store(true); }
+	bool isAnalyzerActive() const { return editorVisible.load(); }
 
 	class FilterAttachment
 	{
@@ -372,12 +655,177 @@ private:
 
 	MonoChain leftChain, rightChain;
 
+	// The cuts run outside the chain, whose LowCut and HighCut positions stay bypassed
+	CrossfadingCut leftLowCut, rightLowCut, leftHighCut, rightHighCut;
+
+	// The same chain expanded into parallel sections, used in ProcessingMode::Parallel
+	// whenever the expansion is well conditioned
+	bool updateParallelFilters();
+	ParallelIIRDesign parallelDesign;
+	ParallelIIR leftParallel, rightParallel;
+
+	// The same sections run four samples at a time, for ProcessingMode::BlockStateSpace
+	void updateBlockFilters();
+	BlockStateSpaceIIR leftBlockFilter, rightBlockFilter;
+
+	// The whole EQ as one gain curve, for ProcessingMode::Stft. Curves are
+	// designed on the worker pool, requested through handleAsyncUpdate because
+	// the audio thread can't queue jobs itself. Each request bumps the
+	// generation and only the newest one's curve is published. The latency is
+	// reported the same way, as hosts expect it from the message thread.
+	void requestStftDesign();
+	StftEqualiser stftEqualiser;
+	juce::SharedResourcePointer<WorkerPool> workerPool;
+
+	// Polls the editor's visibility and refreshes the plots, meter labels and
+	// logs at FrameScheduler::monitorRateHz, on the tick the editors share
+	juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+	std::atomic<bool> stftDesignPending{ false };
+	std::atomic<uint32_t> stftDesignGeneration{ 0 };
+	std::atomic<int> stftExcludedBands{ 0 };
+	std::atomic<int> latencyToReport{ 0 };
+
+	// After a global bypass the STFT has nothing to output for a frame, so
+	// the output stays dry until it has
+	int stftWarmupRemaining = 0;
+
+	// Runs on the STFT equaliser's frames, with or without its curve. Either
+	// one keeps the STFT running and its latency reported.
+	ResonanceSuppressor resonanceSuppressor;
+	bool appliedSuppression = false;
+	bool stftActive = false;
+
+	// What processBlock actually runs, the cascade whenever the selected mode can't be used
+	ProcessingMode activeMode = ProcessingMode::Cascade;
+
+	// Filters are only redesigned when a setting, the processing mode, the
+	// set of modulated bands or the resonance suppression switch changes
+	ChainSettings appliedSettings;
+
+	// Set by any parameter change, so blocks with no changes don't read the parameters at all
+	std::atomic<bool> parametersChanged{ true };
+
+	// The ones processBlock reads every block, looked up once rather than by name
+	std::atomic<float>* bypassParameter = nullptr;
+	std::atomic<float>* analyzerBypassedParameter = nullptr;
+	std::atomic<float>* analyzerModeParameter = nullptr;
+
+	ProcessingMode appliedMode = ProcessingMode::Cascade;
+	int appliedModulatedBands = 0;
+	bool filtersNeedUpdate = true;
+
+	// Picks the realisation for the processing mode from the chain as designed
+	void updateRealisation(ProcessingMode mode);
+
+	// A/B compare. Each slot holds settings and coefficients designed on the
+	// message thread, so switching costs the audio thread a pointer swap. The
+	// cascade then crossfades from the filters it swapped out, which carry on
+	// from their own state. The other realisations keep no state for the
+	// outgoing slot, so they swap at the bottom of a short dip instead. The
+	// inactive slot does nothing until it's switched to.
+	struct AbSlot
+	{
+		ChainSettings settings;
+		CoefficientRefArray lowCut, highCut;
+		std::array<Coefficients, 5> peaks;
+		std::vector<Coefficients> retired;
+
+		// Its own previous objects, plus what one swap takes out of the two
+		// chains and the four cut filters
+		static constexpr size_t retiredCapacity = (2 * NUM_FILTER_SLOPES + 5) + 2 * 5 + 4 * NUM_FILTER_SLOPES;
+	};
+
+	// The cascade an A/B crossfade fades from, swapped out of the live members
+	// whole. Idle between switches.
+	struct AbOutgoing
+	{
+		MonoChain leftChain, rightChain;
+		CrossfadingCut leftLowCut, rightLowCut, leftHighCut, rightHighCut;
+		juce::AudioBuffer<float> buffer;
+	};
+
+	void toggleAB();
+	static void designSlot(AbSlot& slot, double sampleRate);
+	void swapInSlot(AbSlot& slot);
+	void swapOutCascade();
+	void crossfadeFromOutgoing(float* left, float* right, int numSamples) noexcept;
+
+	std::array<AbSlot, 2> abSlots;
+	std::atomic<int> activeSlot{ 0 };
+	std::atomic<int> pendingSlot{ -1 };
+	std::atomic<bool> abParametersSyncing{ false };
+	juce::SmoothedValue<float> abGain{ 1.f };
+	static constexpr double abFadeSeconds = 0.005;
+	AbOutgoing abOutgoing;
+	juce::SmoothedValue<float> abCrossfade{ 1.f };
+
+	// Modulated peaks are bypassed in the chain and run by the matrix instead
+	ModulationMatrix modulation{ apvts };
+
+	// Bypassing a peak fades it out and then takes it out of the chain, so a
+	// bypassed band costs nothing. While any fade runs the cascade is processed
+	// band by band. The other realisations drop the band when its fade ends.
+	// A band handed to the modulation matrix fades out the same way while the
+	// matrix fades it in, and back again when its modulation ends.
+	template<int Index>
+	void updatePeakBand(bool isModulated, bool isBypassed);
+	template<int Index>
+	void processPeakBand(float* left, float* right, int numSamples) noexcept;
+	template<int Index>
+	void retirePeakBandIfFaded();
+
+	std::array<juce::SmoothedValue<float>, 5> peakWet;
+	juce::AudioBuffer<float> peakFadeScratch;
+	static constexpr double bypassFadeSeconds = 0.01;
+
+	// Global bypass fades to the dry input, then returns before any processing
+	juce::SmoothedValue<float> globalWet{ 1.f };
+	juce::AudioBuffer<float> dryBuffer;
+	bool wasBypassed = false;
+
+	// Silences every filter, for when the signal they've been following is gone
+	void resetFilterState();
+
+	// Output that is non-finite or far out of range resets every filter and is
+	// replaced by silence. monitorTick() logs it, the audio thread only counts.
+	std::atomic<int> healthResets{ 0 };
+	std::atomic<int> lastHealthStatus{ static_cast<int>(SignalHealth::Status::Healthy) };
+	int loggedHealthResets = 0;
+
+	// Measure whatever leaves processBlock, including a bypass fade, but not
+	// the input passed straight through once fully bypassed. Both start again
+	// with each prepareToPlay or resetMeters(), and an offline render logs
+	// their results when the host releases resources.
+	void meterOutput(const juce::AudioBuffer<float>& buffer);
+	void updateMeterLabels();
+	LoudnessMeter loudnessMeter;
+	TruePeakMeter truePeakMeter;
+	std::atomic<bool> metersResetPending{ false };
+
+	// The output gain stage: "Output Gain" plus, with "Auto Gain" on, the
+	// negative of the curve's estimated loudness change. The estimate is
+	// made on the worker pool whenever the filters are redesigned, the audio
+	// thread only ramps to it. Each part and the total are kept within
+	// GainCompensation::maxCompensationDb, the range of "Output Gain". gain
+	// holds the linear total for the sum plot.
+	void requestCompensationDesign();
+	float getOutputGainTarget() const noexcept;
+	GainCompensation gainCompensation;
+	std::atomic<bool> compensationDesignPending{ false };
+	std::atomic<uint32_t> compensationDesignGeneration{ 0 };
+	std::atomic<float> compensationDb{ 0.f };
+	float outputGainDb = 0.f;
+	bool autoGainEnabled = false;
+	juce::SmoothedValue<float> outputGain{ 1.f };
+	static constexpr double outputGainRampSeconds = 0.05;
+
 	std::atomic<float> gain{ 1.0f };
 
 	void updatePeakFilter(const ChainSettings& chainSettings);
 	void updateFilters();
-	template<int Index>
 	void updateCutFilter(
+		CrossfadingCut& leftCut,
+		CrossfadingCut& rightCut,
 		const float cutFreq,
 		const Slope slope,
 		CoefficientRefArray(*filterDesignMethod)(float, double, int),
@@ -392,8 +840,63 @@ private:
 	std::array<FilterAttachment*, 5> attachments
 	{ &attachment1, &attachment2, &attachment3, &attachment4, &attachment5 };
 
-	foleys::MagicPlotSource* analyzer = nullptr;
-	foleys::MagicFilterPlot* plotSum = nullptr;
+	SpectrumAnalyser* analyzer = nullptr;
+	std::array<ResponseCurvePlot*, 5> bandPlots{};
+	ResponseCurvePlot* plotSum = nullptr;
+
+	// The plots are designed on the message thread from the parameters, never
+	// from the coefficients the audio thread is using
+	void updateResponsePlots();
+	ChainSettings plottedSettings;
+	double plottedSampleRate = 0.0;
+	float plottedGain = 1.f;
+
+	LoadGovernor loadGovernor;
+
+	// The audio thread only steps the tier, monitorTick() logs each change
+	int loggedQualityTier = 0;
+
+	// Nothing is fed to the analyzer while no editor is on screen
+	std::atomic<bool> editorVisible{ false };
+	bool analyzerWasFed = false;
+	AnalyzerWarmupBuffer analyzerWarmup;
+
+#if SIMPLEEQ_BUILD_CLAP
+	// Host events apply a value and tell the listeners, the parameter listener
+	// below must not send those back. Set on whichever thread is applying them.
+	void applyClapEvent(const clap_event_param_value& event);
+	static thread_local bool applyingClapEvents;
+
+	// Editor edits and gestures, queued on the message thread and pushed to the
+	// host's output events by the next process or flush. Nothing is queued until
+	// the host has called one of them, so VST3 and AU builds leave it empty.
+	void parameterValueChanged(int parameterIndex, float newValue) override;
+	void parameterGestureChanged(int parameterIndex, bool gestureIsStarting) override;
+	void queueClapEvent(uint16_t type, int parameterIndex, double value);
+	void sendClapEvents(const clap_output_events* out);
+
+	struct ClapOutEvent
+	{
+		uint16_t type = CLAP_EVENT_PARAM_VALUE;
+		clap_id paramId = 0;
+		double value = 0.0;
+	};
+	std::array<ClapOutEvent, 256> clapOutEvents;
+	juce::AbstractFifo clapOutFifo{ static_cast<int>(clapOutEvents.size()) };
+	std::atomic<bool> clapEventsDrained{ false };
+
+	// The extensions derive each CLAP id from the parameter ID's hash. By
+	// parameter index, and sorted by id for events that come without a cookie.
+	std::vector<clap_id> clapIds;
+	std::vector<std::pair<clap_id, juce::RangedAudioParameter*>> parametersByClapId;
+#endif
+
+	// Declared last so it is torn down before anything its tasks touch
+	DeferredPreparation preparation;
+
+	// The paint test in SimpleEQTests drives the analyzer and the plots itself
+	// while rendering offscreen
+	friend class PaintBenchmark;
 	//==============================================================================
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimpleEQAudioProcessor)
 };
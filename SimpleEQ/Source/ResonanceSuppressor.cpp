@@ -0,0 +1,139 @@
+/*
+  ==============================================================================
+
+	ResonanceSuppressor.cpp
+
+  ==============================================================================
+*/
+
+#include "ResonanceSuppressor.h"
+
+namespace
+{
+	// A third of an octave either side, and never fewer than a few bins
+	const float neighbourhood_ratio = 0.26f;
+	const int min_neighbourhood_bins = 3;
+
+	// Left out of the neighbourhood, so a tone's main lobe doesn't raise its own reference
+	const int main_lobe_bins = 2;
+
+	float getFrameCoefficient(double sampleRate, int hopSize, float seconds)
+	{
+		return static_cast<float>(1.0 - std::exp(-hopSize / (sampleRate * seconds)));
+	}
+}
+
+void ResonanceSuppressor::prepare(double newSampleRate, int numBins, int hopSize, int numChannels)
+{
+	sampleRate = newSampleRate;
+	fftSize = 2 * (numBins - 1);
+
+	const auto size = static_cast<size_t>(numBins);
+	channels.resize(static_cast<size_t>(numChannels));
+	for (auto& channel : channels)
+	{
+		channel.power.assign(size, 0.f);
+		channel.gain.assign(size, 1.f);
+	}
+
+	first.resize(size);
+	last.resize(size);
+	inverseWidth.resize(size);
+	for (int bin = 0; bin < numBins; ++bin)
+	{
+		const auto half = juce::jmax(min_neighbourhood_bins, juce::roundToInt(static_cast<float>(bin) * neighbourhood_ratio));
+		const auto index = static_cast<size_t>(bin);
+		first[index] = juce::jmax(0, bin - half);
+		last[index] = juce::jmin(numBins - 1, bin + half);
+
+		const auto excluded = juce::jmin(numBins - 1, bin + main_lobe_bins) - juce::jmax(0, bin - main_lobe_bins) + 1;
+		inverseWidth[index] = 1.f / static_cast<float>(last[index] - first[index] + 1 - excluded);
+	}
+
+	frame.assign(size, 0.f);
+	target.assign(size, 1.f);
+	amplitude.assign(size, 1.f);
+	prefix.assign(size + 1, 0.0);
+
+	powerCoefficient = getFrameCoefficient(sampleRate, hopSize, powerSmoothingSeconds);
+	attackCoefficient = getFrameCoefficient(sampleRate, hopSize, attackSeconds);
+	releaseCoefficient = getFrameCoefficient(sampleRate, hopSize, releaseSeconds);
+
+	setRange(20.f, 20000.f);
+	reset();
+}
+
+void ResonanceSuppressor::reset() noexcept
+{
+	for (auto& channel : channels)
+	{
+		std::fill(channel.power.begin(), channel.power.end(), 0.f);
+		std::fill(channel.gain.begin(), channel.gain.end(), 1.f);
+	}
+}
+
+void ResonanceSuppressor::setRange(float lowFrequency, float highFrequency) noexcept
+{
+	const auto numBins = static_cast<int>(frame.size());
+	const auto binsPerHz = fftSize / sampleRate;
+
+	lowBin = juce::jlimit(1, numBins - 1, static_cast<int>(std::ceil(lowFrequency * binsPerHz)));
+	highBin = juce::jlimit(0, numBins - 1, static_cast<int>(std::floor(highFrequency * binsPerHz)));
+}
+
+void ResonanceSuppressor::setDepth(float decibels) noexcept
+{
+	// The gains are kept as power
+	minGain = juce::Decibels::decibelsToGain(-juce::jmax(0.f, decibels), -200.f);
+	minGain *= minGain;
+}
+
+void ResonanceSuppressor::processFrame(int channel, float* bins, int numBins) noexcept
+{
+	if (channel >= static_cast<int>(channels.size()) || numBins != static_cast<int>(frame.size()))
+		return;
+
+	auto& state = channels[static_cast<size_t>(channel)];
+	auto* power = state.power.data();
+	auto* gain = state.gain.data();
+
+	for (int bin = 0; bin < numBins; ++bin)
+		frame[static_cast<size_t>(bin)] = bins[2 * bin] * bins[2 * bin] + bins[2 * bin + 1] * bins[2 * bin + 1];
+
+	// Smoothed over time bin by bin, which takes the frame to frame scatter
+	// out of noise before anything is compared
+	juce::FloatVectorOperations::multiply(power, 1.f - powerCoefficient, numBins);
+	juce::FloatVectorOperations::addWithMultiply(power, frame.data(), powerCoefficient, numBins);
+
+	// Running sums make every neighbourhood average two subtractions, however wide
+	for (int bin = 0; bin < numBins; ++bin)
+		prefix[static_cast<size_t>(bin + 1)] = prefix[static_cast<size_t>(bin)] + power[bin];
+
+	auto sum = [this](int from, int to) { return prefix[static_cast<size_t>(to + 1)] - prefix[static_cast<size_t>(from)]; };
+
+	// Outside the range the gains release back to unity
+	std::fill(target.begin(), target.end(), 1.f);
+	for (int bin = lowBin; bin <= highBin; ++bin)
+	{
+		const auto index = static_cast<size_t>(bin);
+		const auto around = sum(first[index], last[index]) - sum(juce::jmax(0, bin - main_lobe_bins), juce::jmin(numBins - 1, bin + main_lobe_bins));
+		const auto average = static_cast<float>(around) * inverseWidth[index];
+		target[index] = detectionThreshold * average / (power[bin] + 1.0e-20f);
+	}
+
+	juce::FloatVectorOperations::clip(target.data(), target.data(), minGain, 1.f, numBins);
+
+	// Branch free, so these vectorise
+	for (int bin = 0; bin < numBins; ++bin)
+	{
+		const auto coefficient = target[static_cast<size_t>(bin)] < gain[bin] ? attackCoefficient : releaseCoefficient;
+		gain[bin] += coefficient * (target[static_cast<size_t>(bin)] - gain[bin]);
+		amplitude[static_cast<size_t>(bin)] = std::sqrt(gain[bin]);
+	}
+
+	for (int bin = 0; bin < numBins; ++bin)
+	{
+		bins[2 * bin] *= amplitude[static_cast<size_t>(bin)];
+		bins[2 * bin + 1] *= amplitude[static_cast<size_t>(bin)];
+	}
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+	ResonanceSuppressor.h
+
+	Dynamic attenuation of narrow resonances, run on the STFT equaliser's
+	frames so it shares their transforms. Each bin's power is smoothed over a
+	few frames and compared with the average of its neighbours, about a third
+	of an octave either side, leaving out the bins right next to it. Bins
+	that stand more than detectionThreshold above their neighbourhood are
+	pulled back towards it, by at most the depth, with a fast attack and a
+	slower release per bin.
+
+	Only bins between the low and high cut frequencies are touched. All the
+	work is a fixed number of passes over the bins, whatever the signal, so
+	a frame costs the same at any setting. At 48 kHz stereo that is 188
+	frames a second of 1025 bins, budgeted at cpuBudgetPercent of real time
+	on top of the STFT itself. Audio thread only.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+class ResonanceSuppressor
+{
+public:
+	// +6 dB over the neighbourhood
+	static constexpr float detectionThreshold = 4.f;
+	static constexpr float attackSeconds = 0.005f;
+	static constexpr float releaseSeconds = 0.08f;
+	static constexpr float powerSmoothingSeconds = 0.02f;
+
+	// Of one core, at 48 kHz stereo. The test in DspTests logs the cost against it.
+	static constexpr double cpuBudgetPercent = 0.5;
+
+	void prepare(double sampleRate, int numBins, int hopSize, int numChannels);
+	void reset() noexcept;
+
+	void setRange(float lowFrequency, float highFrequency) noexcept;
+	void setDepth(float decibels) noexcept;
+
+	// Bins as StftPipeline::Client::processFrame() gets them
+	void processFrame(int channel, float* bins, int numBins) noexcept;
+
+private:
+	struct ChannelState
+	{
+		std::vector<float> power;
+		std::vector<float> gain;
+	};
+
+	std::vector<ChannelState> channels;
+
+	// Each bin's neighbourhood as [first, last], and 1 / the number of bins
+	// in it once the ones next to the bin are left out
+	std::vector<int> first, last;
+	std::vector<float> inverseWidth;
+
+	std::vector<float> frame, target, amplitude;
+	std::vector<double> prefix;
+
+	double sampleRate = 48000.0;
+	int fftSize = 0;
+	int lowBin = 0;
+	int highBin = 0;
+	float minGain = 1.f;
+	float powerCoefficient = 1.f;
+	float attackCoefficient = 1.f;
+	float releaseCoefficient = 1.f;
+};
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+	ResponseCurvePlot.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseCurvePlot.h"
+
+namespace
+{
+	const double response_min_freq = 20.0;
+	const double response_max_freq = 20000.0;
+}
+
+void ResponseCurvePlot::setIIRCoefficients(CoefficientsPtr coefficients, float maxDB)
+{
+	setIIRCoefficients(1.f, { coefficients }, maxDB);
+}
+
+void ResponseCurvePlot::setIIRCoefficients(float newGain, const std::vector<CoefficientsPtr>& coefficients, float maxDB)
+{
+	{
+		const juce::ScopedLock sl(lock);
+		sections = coefficients;
+		gain = newGain;
+		maxLevelDB = maxDB;
+	}
+
+	++version;
+	resetLastDataFlag();
+}
+
+void ResponseCurvePlot::prepareToPlay(double newSampleRate, int samplesPerBlockExpected)
+{
+	juce::ignoreUnused(samplesPerBlockExpected);
+
+	{
+		const juce::ScopedLock sl(lock);
+		sampleRate = newSampleRate;
+	}
+
+	++version;
+	resetLastDataFlag();
+}
+
+void ResponseCurvePlot::pushSamples(const juce::AudioBuffer<float>& buffer)
+{
+	juce::ignoreUnused(buffer);
+}
+
+void ResponseCurvePlot::createPlotPaths(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds, foleys::MagicPlotComponent& component)
+{
+	juce::ignoreUnused(component);
+	buildCurves(path, filledPath, bounds);
+}
+
+void ResponseCurvePlot::buildCurves(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds)
+{
+	const juce::ScopedLock sl(lock);
+
+	const auto currentVersion = version.load();
+	if (!cache.isValidFor(bounds, currentVersion))
+	{
+		juce::Path newPath;
+		filledPath.clear();
+
+		// One evaluation per pixel column is all the curve can show
+		const auto width = juce::jmax(1, juce::roundToInt(bounds.getWidth()));
+		newPath.preallocateSpace(width * 3 + 3);
+
+		for (int column = 0; column <= width; ++column)
+		{
+			const auto proportion = static_cast<double>(column) / static_cast<double>(width);
+			const auto freq = juce::mapToLog10(proportion, response_min_freq, response_max_freq);
+
+			auto magnitude = static_cast<double>(gain);
+			for (const auto& section : sections)
+				if (section != nullptr)
+					magnitude *= section->getMagnitudeForFrequency(freq, sampleRate);
+
+			const auto db = juce::jlimit(-maxLevelDB, maxLevelDB,
+				juce::Decibels::gainToDecibels(static_cast<float>(magnitude), -maxLevelDB));
+			const auto x = bounds.getX() + static_cast<float>(column);
+			const auto y = juce::jmap(db, -maxLevelDB, maxLevelDB, bounds.getBottom(), bounds.getY());
+
+			if (column == 0)
+				newPath.startNewSubPath(x, y);
+			else
+				newPath.lineTo(x, y);
+		}
+
+		cache.store(newPath, filledPath, bounds, currentVersion);
+	}
+
+	path = cache.path;
+	filledPath = cache.filledPath;
+}
@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+	ResponseCurvePlot.h
+
+	Magnitude response of a set of IIR sections, evaluated once per pixel
+	column. Replaces foleys::MagicFilterPlot for the band and sum plots.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+#include "PlotRendering.h"
+
+class ResponseCurvePlot : public foleys::MagicPlotSource, public CurveSource
+{
+public:
+	using CoefficientsPtr = juce::dsp::IIR::Coefficients<float>::Ptr;
+
+	ResponseCurvePlot() = default;
+
+	// Called from the message thread whenever the filters change
+	void setIIRCoefficients(CoefficientsPtr coefficients, float maxDB);
+	void setIIRCoefficients(float gain, const std::vector<CoefficientsPtr>& coefficients, float maxDB);
+
+	void prepareToPlay(double sampleRate, int samplesPerBlockExpected) override;
+	void pushSamples(const juce::AudioBuffer<float>& buffer) override;
+	void createPlotPaths(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds, foleys::MagicPlotComponent& component) override;
+
+	juce::int64 getCurveVersion() const override { return version.load(); }
+	void buildCurves(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds) override;
+
+private:
+	juce::CriticalSection lock;
+	std::vector<CoefficientsPtr> sections;
+	float gain = 1.f;
+	float maxLevelDB = 24.f;
+	double sampleRate = 48000.0;
+
+	std::atomic<juce::int64> version{ 0 };
+	CachedCurves cache;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ResponseCurvePlot)
+};
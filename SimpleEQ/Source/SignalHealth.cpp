@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+	SignalHealth.cpp
+
+  ==============================================================================
+*/
+
+#include "SignalHealth.h"
+
+namespace
+{
+	constexpr juce::uint32 magnitude_mask = 0x7fffffff;
+	constexpr juce::uint32 infinity_bits = 0x7f800000;
+
+	juce::uint32 getMagnitudeBits(float sample) noexcept
+	{
+		juce::uint32 bits;
+		std::memcpy(&bits, &sample, sizeof(bits));
+		return bits & magnitude_mask;
+	}
+}
+
+juce::uint32 SignalHealth::getPeakBits(const float* samples, int numSamples) noexcept
+{
+	juce::uint32 peak = 0;
+	int i = 0;
+
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<juce::uint32>;
+	constexpr auto laneWidth = static_cast<int>(Lane::SIMDNumElements);
+
+	// Scalar up to the first aligned sample, then whole registers
+	const auto misalignment = static_cast<int>(reinterpret_cast<juce::pointer_sized_uint>(samples) % Lane::SIMDRegisterSize);
+	const auto head = juce::jmin(numSamples, misalignment == 0 ? 0
+		: static_cast<int>((Lane::SIMDRegisterSize - static_cast<size_t>(misalignment)) / sizeof(float)));
+
+	for (; i < head; ++i)
+		peak = juce::jmax(peak, getMagnitudeBits(samples[i]));
+
+	if (numSamples - i >= laneWidth)
+	{
+		const auto mask = Lane::expand(magnitude_mask);
+		auto peaks = Lane::expand(0);
+
+		for (; i + laneWidth <= numSamples; i += laneWidth)
+			peaks = Lane::max(peaks, Lane::fromRawArray(reinterpret_cast<const juce::uint32*>(samples + i)) & mask);
+
+		alignas(Lane::SIMDRegisterSize) juce::uint32 lanes[laneWidth];
+		peaks.copyToRawArray(lanes);
+		for (auto lane : lanes)
+			peak = juce::jmax(peak, lane);
+	}
+#endif
+
+	for (; i < numSamples; ++i)
+		peak = juce::jmax(peak, getMagnitudeBits(samples[i]));
+
+	return peak;
+}
+
+SignalHealth::Status SignalHealth::getStatus(juce::uint32 peakBits) noexcept
+{
+	if (peakBits >= infinity_bits)
+		return Status::NonFinite;
+
+	float peak;
+	std::memcpy(&peak, &peakBits, sizeof(peak));
+	return peak > runawayLevel ? Status::Runaway : Status::Healthy;
+}
+
+SignalHealth::Status SignalHealth::check(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+	juce::uint32 peak = 0;
+	for (int ch = 0; ch < juce::jmin(numChannels, buffer.getNumChannels()); ++ch)
+		peak = juce::jmax(peak, getPeakBits(buffer.getReadPointer(ch), buffer.getNumSamples()));
+
+	return getStatus(peak);
+}
+
+const char* SignalHealth::getDescription(Status status) noexcept
+{
+	switch (status)
+	{
+		case Status::NonFinite: return "non-finite output";
+		case Status::Runaway:   return "runaway output";
+		case Status::Healthy:
+		default:                return "healthy";
+	}
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+	SignalHealth.h
+
+	A cheap per-block check for filters that have gone bad. A NaN or infinity
+	from the host, or a stage pushed unstable, leaves IIR state that never
+	recovers on its own, so the processor scans its output and resets every
+	filter when this reports a problem.
+
+	Denormals aren't looked for. processBlock runs under ScopedNoDenormals,
+	which flushes them before they can slow anything down.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace SignalHealth
+{
+	enum class Status
+	{
+		Healthy,
+		NonFinite,
+		Runaway
+	};
+
+	// +60 dBFS. Nothing the EQ can do to a sane input gets anywhere near it.
+	constexpr float runawayLevel = 1000.f;
+
+	// The largest magnitude in the block, as the bits of a float. With the sign
+	// bit cleared, float bit patterns sort like their magnitudes and infinities
+	// and NaNs sort above every finite value, so a single integer max catches
+	// all of them.
+	juce::uint32 getPeakBits(const float* samples, int numSamples) noexcept;
+
+	Status getStatus(juce::uint32 peakBits) noexcept;
+
+	// Checks the first numChannels channels of the buffer
+	Status check(const juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+	const char* getDescription(Status status) noexcept;
+}
@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+	Spectrogram.cpp
+
+  ==============================================================================
+*/
+
+#include "Spectrogram.h"
+
+namespace
+{
+	const float spectrogram_min_db = -100.f;
+	const float spectrogram_max_db = 0.f;
+	const float spectrogram_min_freq = 20.f;
+	const float spectrogram_max_freq = 20000.f;
+}
+
+SpectrogramComponent::SpectrogramComponent()
+{
+	setOpaque(true);
+
+	const auto mid = juce::Colours::darkblue.brighter();
+	for (size_t i = 0; i < palette.size(); ++i)
+	{
+		auto level = static_cast<float>(i) / static_cast<float>(palette.size() - 1);
+		palette[i] = level < 0.5f
+			? juce::Colours::black.interpolatedWith(mid, level * 2.f)
+			: mid.interpolatedWith(juce::Colours::orange, level * 2.f - 1.f);
+	}
+
+	frameScheduler->addClient(this);
+}
+
+SpectrogramComponent::~SpectrogramComponent()
+{
+	frameScheduler->removeClient(this);
+}
+
+void SpectrogramComponent::setSource(SpectrumAnalyser* sourceToUse)
+{
+	source = sourceToUse;
+	nextFrame = source != nullptr ? source->getNumFramesAnalysed() : 0;
+}
+
+void SpectrogramComponent::resized()
+{
+	// A software image keeps the column writes and the blits on the CPU renderer
+	image = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true, juce::SoftwareImageType());
+	writeX = 0;
+	mappedOrder = 0;
+}
+
+void SpectrogramComponent::paint(juce::Graphics& g)
+{
+	if (!image.isValid())
+	{
+		g.fillAll(juce::Colours::black);
+		return;
+	}
+
+	// Columns [writeX, width) are the oldest, [0, writeX) the newest
+	const auto width = image.getWidth();
+	const auto height = image.getHeight();
+	const auto oldest = width - writeX;
+
+	g.drawImage(image, 0, 0, oldest, height, writeX, 0, oldest, height);
+	if (writeX > 0)
+		g.drawImage(image, oldest, 0, writeX, height, 0, 0, writeX, height);
+}
+
+void SpectrogramComponent::frameTick()
+{
+	if (source == nullptr || !image.isValid())
+		return;
+
+	const auto available = source->getNumFramesAnalysed();
+	if (available == nextFrame)
+		return;
+
+	// Frames that already dropped out of the source's history are skipped
+	nextFrame = juce::jmax(nextFrame, available - SpectrumAnalyser::frameHistorySize);
+
+	auto wroteAny = false;
+	for (; nextFrame < available; ++nextFrame)
+	{
+		int order = 0;
+		double sampleRate = 0.0;
+		if (!source->getFrame(nextFrame, frame, order, sampleRate))
+			continue;
+
+		writeColumn(frame, order, sampleRate);
+		wroteAny = true;
+	}
+
+	if (wroteAny)
+		repaint();
+}
+
+void SpectrogramComponent::updateRowMapping(int fftOrder, double sampleRate)
+{
+	const auto height = image.getHeight();
+	const auto numBins = (1 << fftOrder) / 2 + 1;
+	const auto binWidth = sampleRate / static_cast<double>(1 << fftOrder);
+
+	rowBinStart.resize(static_cast<size_t>(height));
+	rowBinEnd.resize(static_cast<size_t>(height));
+
+	auto binForRowEdge = [&](int edge)
+	{
+		// Row 0 is the top of the image, i.e. the highest frequency
+		auto proportion = 1.0 - static_cast<double>(edge) / static_cast<double>(height);
+		auto freq = juce::mapToLog10(proportion, static_cast<double>(spectrogram_min_freq), static_cast<double>(spectrogram_max_freq));
+		return juce::jlimit(0, numBins - 1, static_cast<int>(freq / binWidth));
+	};
+
+	for (int y = 0; y < height; ++y)
+	{
+		auto start = binForRowEdge(y + 1);
+		auto end = binForRowEdge(y);
+		rowBinStart[static_cast<size_t>(y)] = start;
+		rowBinEnd[static_cast<size_t>(y)] = juce::jmax(start + 1, end);
+	}
+
+	mappedOrder = fftOrder;
+	mappedSampleRate = sampleRate;
+}
+
+void SpectrogramComponent::writeColumn(const std::vector<float>& db, int fftOrder, double sampleRate)
+{
+	if (fftOrder != mappedOrder || sampleRate != mappedSampleRate)
+		updateRowMapping(fftOrder, sampleRate);
+
+	const auto height = image.getHeight();
+	const auto lastPaletteIndex = static_cast<float>(palette.size() - 1);
+	const auto numBins = static_cast<int>(db.size());
+
+	juce::Image::BitmapData pixels(image, writeX, 0, 1, height, juce::Image::BitmapData::writeOnly);
+
+	for (int y = 0; y < height; ++y)
+	{
+		auto level = spectrogram_min_db;
+		const auto end = juce::jmin(rowBinEnd[static_cast<size_t>(y)], numBins);
+		for (int bin = rowBinStart[static_cast<size_t>(y)]; bin < end; ++bin)
+			level = juce::jmax(level, db[static_cast<size_t>(bin)]);
+
+		const auto normalised = juce::jlimit(0.f, 1.f, (level - spectrogram_min_db) / (spectrogram_max_db - spectrogram_min_db));
+		pixels.setPixelColour(0, y, palette[static_cast<size_t>(normalised * lastPaletteIndex)]);
+	}
+
+	writeX = (writeX + 1) % image.getWidth();
+}
+
+//==============================================================================
+SpectrogramItem::SpectrogramItem(foleys::MagicGUIBuilder& builder, const juce::ValueTree& node)
+	: foleys::GuiItem(builder, node)
+{
+	addAndMakeVisible(spectrogram);
+}
+
+void SpectrogramItem::update()
+{
+	auto sourceID = configNode.getProperty(foleys::IDs::source, juce::String()).toString();
+	spectrogram.setSource(sourceID.isNotEmpty()
+		? getMagicState().getObjectWithType<SpectrumAnalyser>(sourceID)
+		: nullptr);
+}
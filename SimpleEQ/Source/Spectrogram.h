@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+	Spectrogram.h
+
+	Scrolling spectrogram of the post-EQ spectrum. Every analysed frame writes
+	one column into a circular software image and paint() blits the two halves
+	of the ring into place, so a frame costs one column of pixels no matter how
+	much history is on screen.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <vector>
+#include "SpectrumAnalyser.h"
+
+class SpectrogramComponent : public juce::Component, private FrameScheduler::Client
+{
+public:
+	SpectrogramComponent();
+	~SpectrogramComponent() override;
+
+	void setSource(SpectrumAnalyser* sourceToUse);
+
+	void paint(juce::Graphics& g) override;
+	void resized() override;
+
+private:
+	juce::Component& getScheduledComponent() override { return *this; }
+	void frameTick() override;
+	void writeColumn(const std::vector<float>& db, int fftOrder, double sampleRate);
+	void updateRowMapping(int fftOrder, double sampleRate);
+
+	juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+	SpectrumAnalyser* source = nullptr;
+	juce::int64 nextFrame = 0;
+
+	juce::Image image;
+	int writeX = 0;
+
+	// Bin range [rowBinStart, rowBinEnd) covered by each pixel row
+	std::vector<int> rowBinStart, rowBinEnd;
+	int mappedOrder = 0;
+	double mappedSampleRate = 0.0;
+
+	std::array<juce::Colour, 256> palette;
+	std::vector<float> frame;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramComponent)
+};
+
+class SpectrogramItem : public foleys::GuiItem
+{
+public:
+	FOLEYS_DECLARE_GUI_FACTORY(SpectrogramItem)
+
+	SpectrogramItem(foleys::MagicGUIBuilder& builder, const juce::ValueTree& node);
+
+	void update() override;
+	juce::Component* getWrappedComponent() override { return &spectrogram; }
+
+private:
+	SpectrogramComponent spectrogram;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramItem)
+};
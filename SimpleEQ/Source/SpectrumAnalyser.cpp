@@ -0,0 +1,354 @@
+/*
+  ==============================================================================
+
+	SpectrumAnalyser.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyser.h"
+#include "PluginProcessor.h"
+
+namespace
+{
+	const float analyser_min_db = -100.f;
+	const float analyser_max_db = 0.f;
+	const float analyser_min_freq = 20.f;
+	const float analyser_max_freq = 20000.f;
+	const float analyser_release = 0.25f;
+	const double analyser_frame_rate = 30.0;
+}
+
+SpectrumAnalyser::SpectrumAnalyser()
+{
+	frameScheduler->addProducer(this);
+}
+
+SpectrumAnalyser::~SpectrumAnalyser()
+{
+	frameScheduler->removeProducer(this);
+	release();
+}
+
+void SpectrumAnalyser::release()
+{
+	// A job that saw prepared is still running and is waited for, later ones return straight away
+	prepared.store(false);
+	workerPool->cancelJobsFor(this);
+	jobPending.store(false);
+}
+
+void SpectrumAnalyser::setSources(ChannelFifo& postLeft, ChannelFifo& postRight, ChannelFifo& preLeft, ChannelFifo& preRight)
+{
+	postLeftFifo = &postLeft;
+	postRightFifo = &postRight;
+	preLeftFifo = &preLeft;
+	preRightFifo = &preRight;
+}
+
+void SpectrumAnalyser::setQuality(int fftOrder, int divisor) noexcept
+{
+	requestedOrder.store(juce::jlimit(minFftOrder, maxFftOrder, fftOrder), std::memory_order_relaxed);
+	frameDivisor.store(juce::jmax(1, divisor), std::memory_order_relaxed);
+}
+
+void SpectrumAnalyser::prepareToPlay(double newSampleRate, int samplesPerBlockExpected)
+{
+	juce::ignoreUnused(samplesPerBlockExpected);
+
+	release();
+
+	sampleRate = newSampleRate;
+
+	for (int order = minFftOrder; order <= maxFftOrder; ++order)
+	{
+		auto index = static_cast<size_t>(order - minFftOrder);
+		auto size = static_cast<size_t>(1 << order);
+
+		ffts[index] = &fftCache->get(order);
+
+		windows[index].resize(size);
+		juce::dsp::WindowingFunction<float>::fillWindowingTables(windows[index].data(), size,
+			juce::dsp::WindowingFunction<float>::hann, false);
+	}
+
+	const auto maxSize = static_cast<size_t>(1 << maxFftOrder);
+	frameA.assign(maxSize, 0.f);
+	frameB.assign(maxSize, 0.f);
+	fftIn.assign(maxSize, {});
+	fftOut.assign(maxSize, {});
+	dbA.assign(maxSize / 2 + 1, analyser_min_db);
+	dbB.assign(maxSize / 2 + 1, analyser_min_db);
+
+	for (auto& s : slots)
+		s.setSize(1, analyzer_fifo_slot_size, false, true, false);
+
+	{
+		const juce::SpinLock::ScopedLockType lock(resultLock);
+		resultA.clear();
+		resultB.clear();
+		resultOrder = 0;
+		resultSampleRate = sampleRate;
+
+		for (auto& frame : frameHistory)
+			frame.reserve(maxSize / 2 + 1);
+	}
+
+	haveNewSamples = false;
+	prepared.store(true);
+}
+
+void SpectrumAnalyser::pushSamples(const juce::AudioBuffer<float>& buffer)
+{
+	juce::ignoreUnused(buffer);
+}
+
+void SpectrumAnalyser::produceFrame(double nowSeconds)
+{
+	if (!prepared.load() || jobPending.load() || postLeftFifo == nullptr)
+		return;
+
+	// The scheduler ticks at the display rate; the analyzer runs slower and
+	// slower still on the reduced quality tiers
+	const auto interval = frameDivisor.load(std::memory_order_relaxed) / analyser_frame_rate;
+	if (nowSeconds - lastFrameSeconds < interval)
+		return;
+
+	// Instances whose editor is closed have nothing queued, don't wake a worker for them
+	if (postLeftFifo->getNumCompleteBuffersAvailable() < 1)
+		return;
+
+	lastFrameSeconds = nowSeconds;
+	jobPending.store(true);
+	workerPool->addJob(this, WorkerPool::TaskType::Analyzer, [this]
+	{
+		if (prepared.load())
+			pullAndAnalyse();
+		jobPending.store(false);
+	});
+}
+
+void SpectrumAnalyser::analyseNow()
+{
+	auto expected = false;
+	if (!prepared.load() || postLeftFifo == nullptr || !jobPending.compare_exchange_strong(expected, true))
+		return;
+
+	pullAndAnalyse();
+	jobPending.store(false);
+}
+
+void SpectrumAnalyser::pullAndAnalyse()
+{
+	while (pullFromFifos())
+		haveNewSamples = true;
+
+	if (!haveNewSamples)
+		return;
+
+	analyseFrame(requestedOrder.load(std::memory_order_relaxed));
+	haveNewSamples = false;
+	resetLastDataFlag();
+}
+
+bool SpectrumAnalyser::pullFromFifos()
+{
+	// The pre and post FIFOs are always fed together, so their slots line up
+	if (postLeftFifo->getNumCompleteBuffersAvailable() < 1
+		|| postRightFifo->getNumCompleteBuffersAvailable() < 1
+		|| preLeftFifo->getNumCompleteBuffersAvailable() < 1
+		|| preRightFifo->getNumCompleteBuffersAvailable() < 1)
+		return false;
+
+	postLeftFifo->getAudioBuffer(slots[0]);
+	postRightFifo->getAudioBuffer(slots[1]);
+	preLeftFifo->getAudioBuffer(slots[2]);
+	preRightFifo->getAudioBuffer(slots[3]);
+
+	const auto numSamples = slots[0].getNumSamples();
+	const auto frameSize = static_cast<int>(frameA.size());
+	jassert(numSamples <= frameSize);
+
+	std::copy(frameA.begin() + numSamples, frameA.end(), frameA.begin());
+	std::copy(frameB.begin() + numSamples, frameB.end(), frameB.begin());
+
+	auto* a = frameA.data() + frameSize - numSamples;
+	auto* b = frameB.data() + frameSize - numSamples;
+
+	if (mode.load(std::memory_order_relaxed) == PrePost)
+	{
+		// a carries the input, b the output, both as mid signals
+		juce::FloatVectorOperations::add(a, slots[2].getReadPointer(0), slots[3].getReadPointer(0), numSamples);
+		juce::FloatVectorOperations::multiply(a, 0.5f, numSamples);
+		juce::FloatVectorOperations::add(b, slots[0].getReadPointer(0), slots[1].getReadPointer(0), numSamples);
+		juce::FloatVectorOperations::multiply(b, 0.5f, numSamples);
+	}
+	else
+	{
+		juce::FloatVectorOperations::copy(a, slots[0].getReadPointer(0), numSamples);
+		juce::FloatVectorOperations::copy(b, slots[1].getReadPointer(0), numSamples);
+	}
+
+	return true;
+}
+
+void SpectrumAnalyser::analyseFrame(int order)
+{
+	const auto index = static_cast<size_t>(order - minFftOrder);
+	const auto size = 1 << order;
+	const auto numBins = size / 2 + 1;
+	const auto start = static_cast<int>(frameA.size()) - size;
+	const auto& window = windows[index];
+	const auto frameMode = mode.load(std::memory_order_relaxed);
+
+	auto windowSum = 0.f;
+	for (int i = 0; i < size; ++i)
+	{
+		fftIn[static_cast<size_t>(i)] = { frameA[static_cast<size_t>(start + i)] * window[static_cast<size_t>(i)],
+			frameB[static_cast<size_t>(start + i)] * window[static_cast<size_t>(i)] };
+		windowSum += window[static_cast<size_t>(i)];
+	}
+
+	ffts[index]->perform(fftIn.data(), fftOut.data(), false);
+
+	// Z = A + iB, so A[k] = (Z[k] + conj(Z[N-k])) / 2 and B[k] = (Z[k] - conj(Z[N-k])) / 2i
+	const auto scale = 2.f / windowSum;
+	for (int k = 0; k < numBins; ++k)
+	{
+		const auto z = fftOut[static_cast<size_t>(k)];
+		const auto zMirror = std::conj(fftOut[static_cast<size_t>((size - k) % size)]);
+		const auto spectrumA = (z + zMirror) * 0.5f;
+		const auto spectrumB = (z - zMirror) * std::complex<float>(0.f, -0.5f);
+
+		if (frameMode == PrePost)
+		{
+			dbA[static_cast<size_t>(k)] = juce::Decibels::gainToDecibels(std::abs(spectrumA) * scale, analyser_min_db);
+			dbB[static_cast<size_t>(k)] = juce::Decibels::gainToDecibels(std::abs(spectrumB) * scale, analyser_min_db);
+		}
+		else
+		{
+			// Left and right are combined by power into a single curve
+			const auto power = 0.5f * (std::norm(spectrumA) + std::norm(spectrumB));
+			dbA[static_cast<size_t>(k)] = juce::Decibels::gainToDecibels(std::sqrt(power) * scale, analyser_min_db);
+		}
+	}
+
+	const juce::SpinLock::ScopedLockType lock(resultLock);
+
+	const auto reset = resultOrder != order || resultMode != frameMode;
+	resultOrder = order;
+	resultMode = frameMode;
+	resultSampleRate = sampleRate;
+
+	auto smooth = [reset, numBins](std::vector<float>& result, const std::vector<float>& db)
+	{
+		if (reset)
+		{
+			result.assign(db.begin(), db.begin() + numBins);
+			return;
+		}
+
+		for (size_t k = 0; k < result.size(); ++k)
+			result[k] = db[k] > result[k] ? db[k] : result[k] + (db[k] - result[k]) * analyser_release;
+	};
+
+	smooth(resultA, dbA);
+
+	if (frameMode == PrePost)
+		smooth(resultB, dbB);
+	else
+		resultB.clear();
+
+	// The history holds the unsmoothed output spectrum
+	const auto& post = frameMode == PrePost ? dbB : dbA;
+	const auto frameIndex = framesAnalysed.load();
+	auto& frame = frameHistory[static_cast<size_t>(frameIndex % frameHistorySize)];
+	frame.assign(post.begin(), post.begin() + numBins);
+	framesAnalysed.store(frameIndex + 1);
+}
+
+bool SpectrumAnalyser::getFrame(juce::int64 frameIndex, std::vector<float>& db, int& fftOrder, double& frameSampleRate)
+{
+	const juce::SpinLock::ScopedLockType lock(resultLock);
+
+	const auto available = framesAnalysed.load();
+	if (frameIndex >= available || frameIndex < available - frameHistorySize)
+		return false;
+
+	db = frameHistory[static_cast<size_t>(frameIndex % frameHistorySize)];
+	fftOrder = juce::roundToInt(std::log2(static_cast<double>((db.size() - 1) * 2)));
+	frameSampleRate = resultSampleRate;
+	return true;
+}
+
+void SpectrumAnalyser::createPlotPaths(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds, foleys::MagicPlotComponent& component)
+{
+	juce::ignoreUnused(component);
+	buildCurves(path, filledPath, bounds);
+}
+
+void SpectrumAnalyser::buildCurves(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds)
+{
+	const auto version = framesAnalysed.load();
+	if (cache.isValidFor(bounds, version))
+	{
+		path = cache.path;
+		filledPath = cache.filledPath;
+		return;
+	}
+
+	int order = 0;
+	double rate = 0.0;
+	Mode drawMode = PostOnly;
+	{
+		const juce::SpinLock::ScopedLockType lock(resultLock);
+		drawA = resultA;
+		drawB = resultB;
+		order = resultOrder;
+		rate = resultSampleRate;
+		drawMode = resultMode;
+	}
+
+	path.clear();
+	filledPath.clear();
+
+	if (order != 0 && !drawA.empty())
+	{
+		const auto binWidth = static_cast<float>(rate) / static_cast<float>(1 << order);
+
+		// Above a few hundred Hz there are many bins per pixel, so the curve is
+		// reduced to one span per column before it becomes a path
+		auto addCurve = [&](juce::Path& p, const std::vector<float>& db, bool close)
+		{
+			decimator.reset(bounds);
+
+			for (size_t k = 1; k < db.size(); ++k)
+			{
+				const auto freq = binWidth * static_cast<float>(k);
+				if (freq < analyser_min_freq)
+					continue;
+				if (freq > analyser_max_freq)
+					break;
+
+				const auto x = bounds.getX() + bounds.getWidth() * juce::mapFromLog10(freq, analyser_min_freq, analyser_max_freq);
+				const auto y = juce::jmap(juce::jlimit(analyser_min_db, analyser_max_db, db[k]),
+					analyser_min_db, analyser_max_db, bounds.getBottom(), bounds.getY());
+				decimator.addPoint(x, y);
+			}
+
+			decimator.createPath(p, close);
+		};
+
+		if (drawMode == PrePost)
+		{
+			addCurve(path, drawB, false);
+			addCurve(filledPath, drawA, true);
+		}
+		else
+		{
+			addCurve(path, drawA, false);
+		}
+	}
+
+	cache.store(path, filledPath, bounds, version);
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+	SpectrumAnalyser.h
+
+	Spectrum display fed from the processor's channel FIFOs. Two real signals
+	are packed into the real and imaginary parts of one complex FFT and split
+	apart afterwards, so showing the pre-EQ and post-EQ spectra together costs
+	roughly the same as showing one. In post-only mode the same trick is used
+	for the left and right channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <complex>
+#include <vector>
+#include "FftCache.h"
+#include "FrameScheduler.h"
+#include "PlotRendering.h"
+#include "WorkerPool.h"
+
+template<typename BlockType>
+struct SingleChannelSampleFifo;
+
+class SpectrumAnalyser : public foleys::MagicPlotSource, public CurveSource, private FrameScheduler::Producer
+{
+public:
+	enum Mode
+	{
+		PostOnly = 0,
+		PrePost
+	};
+
+	using ChannelFifo = SingleChannelSampleFifo<juce::AudioBuffer<float>>;
+
+	SpectrumAnalyser();
+	~SpectrumAnalyser() override;
+
+	void setSources(ChannelFifo& postLeft, ChannelFifo& postRight, ChannelFifo& preLeft, ChannelFifo& preRight);
+
+	void setMode(Mode newMode) noexcept { mode.store(newMode, std::memory_order_relaxed); }
+	Mode getMode() const noexcept { return mode.load(std::memory_order_relaxed); }
+
+	// Set from the audio thread with the current quality tier
+	void setQuality(int fftOrder, int frameDivisor) noexcept;
+
+	void prepareToPlay(double sampleRate, int samplesPerBlockExpected) override;
+
+	// Stops reading the sources and waits for a running analysis, so the FIFOs
+	// can be resized or destroyed. prepareToPlay() starts it again.
+	void release();
+
+	// Analyses whatever is queued on the calling thread, for offscreen rendering
+	// where the frame scheduler never ticks
+	void analyseNow();
+
+	// Samples arrive through the channel FIFOs, not through here
+	void pushSamples(const juce::AudioBuffer<float>& buffer) override;
+
+	void createPlotPaths(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds, foleys::MagicPlotComponent& component) override;
+
+	juce::int64 getCurveVersion() const override { return framesAnalysed.load(); }
+	void buildCurves(juce::Path& path, juce::Path& filledPath, juce::Rectangle<float> bounds) override;
+
+	// Every analysed frame of the post-EQ spectrum is also kept in a short ring,
+	// so views that want the history (the spectrogram) can pick up what they missed.
+	juce::int64 getNumFramesAnalysed() const noexcept { return framesAnalysed.load(); }
+	bool getFrame(juce::int64 frameIndex, std::vector<float>& db, int& fftOrder, double& frameSampleRate);
+	static constexpr int frameHistorySize = 16;
+
+	static constexpr int minFftOrder = 10;
+	static constexpr int maxFftOrder = 12;
+
+private:
+	void produceFrame(double nowSeconds) override;
+
+	// Runs on the worker pool, never more than one at a time
+	void pullAndAnalyse();
+	bool pullFromFifos();
+	void analyseFrame(int order);
+
+	juce::SharedResourcePointer<WorkerPool> workerPool;
+	juce::SharedResourcePointer<FftCache> fftCache;
+	juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+
+	ChannelFifo* postLeftFifo = nullptr;
+	ChannelFifo* postRightFifo = nullptr;
+	ChannelFifo* preLeftFifo = nullptr;
+	ChannelFifo* preRightFifo = nullptr;
+
+	std::atomic<Mode> mode{ PostOnly };
+	std::atomic<int> requestedOrder{ maxFftOrder };
+	std::atomic<int> frameDivisor{ 1 };
+	std::atomic<bool> jobPending{ false };
+	std::atomic<bool> prepared{ false };
+	double lastFrameSeconds = 0.0;
+
+	double sampleRate = 48000.0;
+
+	// Owned by the worker job
+	std::array<const juce::dsp::FFT*, maxFftOrder - minFftOrder + 1> ffts{};
+	std::array<std::vector<float>, maxFftOrder - minFftOrder + 1> windows;
+	std::array<juce::AudioBuffer<float>, 4> slots;
+	std::vector<float> frameA, frameB;
+	std::vector<std::complex<float>> fftIn, fftOut;
+	std::vector<float> dbA, dbB;
+	bool haveNewSamples = false;
+
+	// Shared between the worker and the message thread
+	juce::SpinLock resultLock;
+	std::vector<float> resultA, resultB;
+	int resultOrder = 0;
+	double resultSampleRate = 48000.0;
+	Mode resultMode = PostOnly;
+	std::array<std::vector<float>, frameHistorySize> frameHistory;
+	std::atomic<juce::int64> framesAnalysed{ 0 };
+
+	// Message thread only
+	std::vector<float> drawA, drawB;
+	ColumnDecimator decimator;
+	CachedCurves cache;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyser)
+};
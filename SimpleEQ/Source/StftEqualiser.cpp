@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+	StftEqualiser.cpp
+
+  ==============================================================================
+*/
+
+#include "StftEqualiser.h"
+
+void StftEqualiser::prepare(double newSampleRate, int maximumBlockSize, int numChannels)
+{
+	juce::ignoreUnused(maximumBlockSize);
+
+	const juce::SpinLock::ScopedLockType lock(writerLock);
+
+	sampleRate = newSampleRate;
+	pipeline.prepare(getFftOrder(sampleRate), numChannels);
+
+	// Flat until the first design arrives
+	for (auto& curve : curves)
+		curve.assign(static_cast<size_t>(2 * pipeline.getNumBins()), 1.f);
+
+	middle.store(1);
+	front = 0;
+	back = 2;
+
+	dryDelay.setSize(numChannels, pipeline.getLatencySamples(), false, true, false);
+	reset();
+}
+
+void StftEqualiser::reset() noexcept
+{
+	resetFrames();
+	dryDelay.clear();
+	dryDelayPosition = 0;
+}
+
+void StftEqualiser::resetFrames() noexcept
+{
+	pipeline.reset();
+}
+
+void StftEqualiser::process(juce::AudioBuffer<float>& buffer, int numChannels, bool applyCurve, ResonanceSuppressor* suppressor) noexcept
+{
+	if (middle.load(std::memory_order_relaxed) & freshCurve)
+		front = middle.exchange(front, std::memory_order_acq_rel) & ~freshCurve;
+
+	curveEnabled = applyCurve;
+	frameSuppressor = suppressor;
+	pipeline.process(buffer, numChannels, *this);
+}
+
+void StftEqualiser::processFrame(int channel, float* bins, int numBins) noexcept
+{
+	if (curveEnabled)
+		juce::FloatVectorOperations::multiply(bins, curves[static_cast<size_t>(front)].data(), 2 * numBins);
+
+	if (frameSuppressor != nullptr)
+		frameSuppressor->processFrame(channel, bins, numBins);
+}
+
+void StftEqualiser::delayDry(juce::AudioBuffer<float>& buffer, int numChannels) noexcept
+{
+	numChannels = juce::jmin(numChannels, buffer.getNumChannels(), dryDelay.getNumChannels());
+	const auto length = dryDelay.getNumSamples();
+	const auto numSamples = buffer.getNumSamples();
+
+	for (int start = 0; start < numSamples;)
+	{
+		const auto num = juce::jmin(numSamples - start, length - dryDelayPosition);
+
+		// Swap the block with what went into the ring one latency ago
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			auto* samples = buffer.getWritePointer(ch, start);
+			auto* ring = dryDelay.getWritePointer(ch, dryDelayPosition);
+			for (int i = 0; i < num; ++i)
+				std::swap(samples[i], ring[i]);
+		}
+
+		start += num;
+		dryDelayPosition = (dryDelayPosition + num) % length;
+	}
+}
+
+void StftEqualiser::setMagnitudes(const float* magnitudes, int numBins)
+{
+	const juce::SpinLock::ScopedLockType lock(writerLock);
+
+	auto& curve = curves[static_cast<size_t>(back)];
+	if (numBins * 2 != static_cast<int>(curve.size()))
+		return;
+
+	for (int bin = 0; bin < numBins; ++bin)
+		curve[static_cast<size_t>(2 * bin)] = curve[static_cast<size_t>(2 * bin + 1)] = magnitudes[bin];
+
+	back = middle.exchange(back | freshCurve, std::memory_order_acq_rel) & ~freshCurve;
+}
+
+void StftEqualiser::designMagnitudes(
+	const juce::dsp::IIR::Coefficients<float>* const* sections,
+	int numSections,
+	double sampleRate,
+	float* magnitudes,
+	int numBins)
+{
+	const auto fftSize = 2 * (numBins - 1);
+	std::vector<double> frequencies(static_cast<size_t>(numBins)), product(static_cast<size_t>(numBins), 1.0), section(static_cast<size_t>(numBins));
+
+	for (int bin = 0; bin < numBins; ++bin)
+		frequencies[static_cast<size_t>(bin)] = bin * sampleRate / fftSize;
+
+	for (int s = 0; s < numSections; ++s)
+	{
+		sections[s]->getMagnitudeForFrequencyArray(frequencies.data(), section.data(), static_cast<size_t>(numBins), sampleRate);
+		for (size_t bin = 0; bin < product.size(); ++bin)
+			product[bin] *= section[bin];
+	}
+
+	for (size_t bin = 0; bin < product.size(); ++bin)
+		magnitudes[bin] = static_cast<float>(product[bin]);
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+	StftEqualiser.h
+
+	Applies the whole EQ as one gain per STFT bin, so the cost is the same for
+	five bands as for thirty. The gains are the magnitude response of the
+	sections being replaced, applied with zero phase. The result is linear
+	phase, a little smeared in time at the frame length, and the pipeline's
+	latency late.
+
+	Curves are designed off the audio thread and handed over through three
+	buffers: the audio thread reads one, the designer writes another, and
+	they swap through the third without locking. The audio thread picks up
+	a new curve at the start of a block.
+
+	Resonance suppression runs on the same frames, after the curve, so the
+	two together still cost one pair of transforms per hop. With the curve
+	off the equaliser is just the frame for the suppressor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "ResonanceSuppressor.h"
+#include "StftPipeline.h"
+
+class StftEqualiser : private StftPipeline::Client
+{
+public:
+	void prepare(double sampleRate, int maximumBlockSize, int numChannels);
+	void reset() noexcept;
+
+	// Restarts the frames but keeps the dry delay running, for when the output
+	// restarts but the dry signal lined up against it hasn't
+	void resetFrames() noexcept;
+
+	void process(juce::AudioBuffer<float>& buffer, int numChannels, bool applyCurve = true, ResonanceSuppressor* suppressor = nullptr) noexcept;
+
+	// Delays a dry signal by the latency, so it lines up with the output of process()
+	void delayDry(juce::AudioBuffer<float>& buffer, int numChannels) noexcept;
+
+	int getLatencySamples() const noexcept { return pipeline.getLatencySamples(); }
+	int getNumBins() const noexcept { return pipeline.getNumBins(); }
+	int getHopSize() const noexcept { return pipeline.getHopSize(); }
+	double getSampleRate() const noexcept { return sampleRate; }
+
+	// From any thread but the audio thread. numBins magnitudes, one per bin.
+	void setMagnitudes(const float* magnitudes, int numBins);
+
+	// The magnitude response of a cascade at each bin frequency, multiplied together
+	static void designMagnitudes(
+		const juce::dsp::IIR::Coefficients<float>* const* sections,
+		int numSections,
+		double sampleRate,
+		float* magnitudes,
+		int numBins);
+
+	static int getFftOrder(double sampleRate) noexcept { return sampleRate > 50000.0 ? 12 : 11; }
+
+private:
+	void processFrame(int channel, float* bins, int numBins) noexcept override;
+
+	StftPipeline pipeline;
+	double sampleRate = 44100.0;
+
+	// Interleaved like the bins, each gain twice
+	std::array<std::vector<float>, 3> curves;
+	static constexpr int freshCurve = 4;
+	std::atomic<int> middle{ 1 };
+	int front = 0;
+	int back = 2;
+	juce::SpinLock writerLock;
+
+	// For the block being processed
+	bool curveEnabled = true;
+	ResonanceSuppressor* frameSuppressor = nullptr;
+
+	juce::AudioBuffer<float> dryDelay;
+	int dryDelayPosition = 0;
+};
@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+	StftPipeline.cpp
+
+  ==============================================================================
+*/
+
+#include "StftPipeline.h"
+
+void StftPipeline::prepare(int fftOrder, int numChannels)
+{
+	fft = &fftCache->get(fftOrder);
+
+	fftSize = 1 << fftOrder;
+	hopSize = fftSize / overlap;
+
+	// Periodic, so the overlapping windows add up exactly
+	window.resize(static_cast<size_t>(fftSize));
+	for (int i = 0; i < fftSize; ++i)
+		window[static_cast<size_t>(i)] = std::sqrt(0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * static_cast<float>(i) / static_cast<float>(fftSize)));
+
+	// Hann windows a quarter apart add up to 2
+	outputScale = 2.f / static_cast<float>(overlap);
+
+	frame.assign(static_cast<size_t>(2 * fftSize), 0.f);
+	channels.resize(static_cast<size_t>(numChannels));
+	for (auto& channel : channels)
+	{
+		channel.input.assign(static_cast<size_t>(fftSize), 0.f);
+		channel.output.assign(static_cast<size_t>(fftSize), 0.f);
+	}
+
+	reset();
+}
+
+void StftPipeline::reset() noexcept
+{
+	for (auto& channel : channels)
+	{
+		std::fill(channel.input.begin(), channel.input.end(), 0.f);
+		std::fill(channel.output.begin(), channel.output.end(), 0.f);
+	}
+
+	hopPosition = 0;
+}
+
+void StftPipeline::process(juce::AudioBuffer<float>& buffer, int numChannels, Client& client) noexcept
+{
+	numChannels = juce::jmin(numChannels, buffer.getNumChannels(), static_cast<int>(channels.size()));
+	const auto numSamples = buffer.getNumSamples();
+
+	for (int start = 0; start < numSamples;)
+	{
+		const auto num = juce::jmin(numSamples - start, hopSize - hopPosition);
+
+		for (int ch = 0; ch < numChannels; ++ch)
+		{
+			auto& state = channels[static_cast<size_t>(ch)];
+			auto* samples = buffer.getWritePointer(ch, start);
+
+			// New input goes into the last hop of the frame, finished output comes off the front
+			juce::FloatVectorOperations::copy(state.input.data() + fftSize - hopSize + hopPosition, samples, num);
+			juce::FloatVectorOperations::copy(samples, state.output.data() + hopPosition, num);
+		}
+
+		start += num;
+		hopPosition += num;
+
+		if (hopPosition == hopSize)
+		{
+			for (int ch = 0; ch < numChannels; ++ch)
+				runFrame(ch, client);
+
+			hopPosition = 0;
+		}
+	}
+}
+
+void StftPipeline::runFrame(int channel, Client& client) noexcept
+{
+	auto& state = channels[static_cast<size_t>(channel)];
+	auto* data = frame.data();
+
+	juce::FloatVectorOperations::multiply(data, state.input.data(), window.data(), fftSize);
+	juce::FloatVectorOperations::clear(data + fftSize, fftSize);
+
+	fft->performRealOnlyForwardTransform(data, true);
+	client.processFrame(channel, data, getNumBins());
+	fft->performRealOnlyInverseTransform(data);
+
+	// Move both buffers on by a hop, then add this frame in
+	auto& output = state.output;
+	std::copy(output.begin() + hopSize, output.end(), output.begin());
+	std::fill(output.end() - hopSize, output.end(), 0.f);
+
+	juce::FloatVectorOperations::multiply(data, window.data(), fftSize);
+	juce::FloatVectorOperations::addWithMultiply(output.data(), data, outputScale, fftSize);
+
+	auto& input = state.input;
+	std::copy(input.begin() + hopSize, input.end(), input.begin());
+}
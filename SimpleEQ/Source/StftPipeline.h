@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+	StftPipeline.h
+
+	Overlap-add short-time Fourier transform for spectral processing. Each
+	channel is cut into frames of fftSize samples every fftSize / 4, windowed
+	with a square-root Hann window before the forward transform and again
+	after the inverse one. The two windows multiply to a Hann window, which
+	sums to a constant at this overlap, so a client that leaves the spectrum
+	alone gets the input back exactly, fftSize samples late.
+
+	The pipeline owns the framing; the transforms come from the FftCache it
+	shares with the analyzers. What happens to each frame's spectrum is up to
+	the client passed to process().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+#include "FftCache.h"
+
+class StftPipeline
+{
+public:
+	struct Client
+	{
+		virtual ~Client() = default;
+
+		// bins holds bins 0 to fftSize / 2 as interleaved real and imaginary parts
+		virtual void processFrame(int channel, float* bins, int numBins) noexcept = 0;
+	};
+
+	static constexpr int overlap = 4;
+
+	void prepare(int fftOrder, int numChannels);
+	void reset() noexcept;
+
+	// In place on the first numChannels channels
+	void process(juce::AudioBuffer<float>& buffer, int numChannels, Client& client) noexcept;
+
+	int getFftSize() const noexcept { return fftSize; }
+	int getHopSize() const noexcept { return hopSize; }
+	int getNumBins() const noexcept { return fftSize / 2 + 1; }
+	int getLatencySamples() const noexcept { return fftSize; }
+
+private:
+	void runFrame(int channel, Client& client) noexcept;
+
+	struct ChannelState
+	{
+		// The last fftSize input samples, and the overlap-add sum still to be output
+		std::vector<float> input, output;
+	};
+
+	juce::SharedResourcePointer<FftCache> fftCache;
+	const juce::dsp::FFT* fft = nullptr;
+	std::vector<float> window;
+	std::vector<float> frame;
+	std::vector<ChannelState> channels;
+	int fftSize = 0;
+	int hopSize = 0;
+	int hopPosition = 0;
+	float outputScale = 1.f;
+};
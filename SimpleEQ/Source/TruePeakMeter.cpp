@@ -0,0 +1,150 @@
+/*
+  ==============================================================================
+
+	TruePeakMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "TruePeakMeter.h"
+
+namespace
+{
+	const float kaiser_beta = 5.f;
+}
+
+TruePeakMeter::TruePeakMeter()
+{
+	// Low pass at the input's Nyquist frequency, on the 4x grid
+	constexpr int length = phases * tapsPerPhase;
+	std::array<float, length> window;
+	juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(), length,
+		juce::dsp::WindowingFunction<float>::kaiser, false, kaiser_beta);
+
+	const auto centre = (length - 1) / 2.0;
+	std::array<float, length> h;
+	for (int n = 0; n < length; ++n)
+	{
+		const auto t = juce::MathConstants<double>::pi * (n - centre) / phases;
+		h[static_cast<size_t>(n)] = static_cast<float>(std::sin(t) / t) * window[static_cast<size_t>(n)];
+	}
+
+	phaseBound = 0.f;
+	for (int p = 0; p < phases; ++p)
+	{
+		// Every phase passes DC at unity
+		auto sum = 0.f, magnitude = 0.f;
+		for (int k = 0; k < tapsPerPhase; ++k)
+			sum += h[static_cast<size_t>(p + phases * k)];
+
+		for (int k = 0; k < tapsPerPhase; ++k)
+		{
+			const auto tap = h[static_cast<size_t>(p + phases * k)] / sum;
+			magnitude += std::abs(tap);
+			for (int ch = 0; ch < maxChannels; ++ch)
+				taps[static_cast<size_t>(k * numLanes + ch * phases + p)] = tap;
+		}
+
+		phaseBound = juce::jmax(phaseBound, magnitude);
+	}
+
+	reset();
+}
+
+void TruePeakMeter::reset() noexcept
+{
+	history.fill(0.f);
+
+	position = 0;
+	peaks.fill(0.f);
+	historyPeak.fill(0.f);
+
+	for (auto& peak : truePeak)
+		peak.store(0.f);
+}
+
+float TruePeakMeter::getTruePeakDb(int channel) const noexcept
+{
+	return juce::Decibels::gainToDecibels(truePeak[static_cast<size_t>(juce::jlimit(0, maxChannels - 1, channel))].load(std::memory_order_relaxed));
+}
+
+juce::String TruePeakMeter::getReport() const
+{
+	return "true peak L " + juce::String(getTruePeakDb(0), 1) + " dBTP, R " + juce::String(getTruePeakDb(1), 1) + " dBTP";
+}
+
+void TruePeakMeter::pushSample(const std::array<const float*, maxChannels>& channels, int numChannels, int index) noexcept
+{
+	auto* row = history.data() + position * numLanes;
+	for (int ch = 0; ch < numChannels; ++ch)
+		std::fill_n(row + ch * phases, phases, channels[static_cast<size_t>(ch)][index]);
+
+	std::copy_n(row, numLanes, row + tapsPerPhase * numLanes);
+	position = (position + 1) % tapsPerPhase;
+}
+
+void TruePeakMeter::process(const juce::AudioBuffer<float>& buffer) noexcept
+{
+	const auto numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+	const auto numSamples = buffer.getNumSamples();
+	if (numSamples == 0)
+		return;
+
+	std::array<const float*, maxChannels> channels{};
+	auto canRise = false;
+
+	for (int ch = 0; ch < numChannels; ++ch)
+	{
+		const auto index = static_cast<size_t>(ch);
+		channels[index] = buffer.getReadPointer(ch);
+
+		const auto inputPeak = juce::jmax(buffer.getMagnitude(ch, 0, numSamples), historyPeak[index]);
+		canRise = canRise || inputPeak * phaseBound > truePeak[index].load(std::memory_order_relaxed);
+
+		// What stays in the history for the next block
+		const auto tail = juce::jmin(numSamples, tapsPerPhase);
+		historyPeak[index] = buffer.getMagnitude(ch, numSamples - tail, tail);
+	}
+
+	if (!canRise)
+	{
+		for (int i = juce::jmax(0, numSamples - tapsPerPhase); i < numSamples; ++i)
+			pushSample(channels, numChannels, i);
+		return;
+	}
+
+	for (int i = 0; i < numSamples; ++i)
+	{
+		pushSample(channels, numChannels, i);
+
+		// Input i - k is k rows before input i
+		const auto* newest = history.data() + (position + tapsPerPhase - 1) * numLanes;
+
+#if JUCE_USE_SIMD
+		for (int lane = 0; lane < numLanes; lane += laneWidth)
+		{
+			auto sum = Lane::expand(0.f);
+			for (int k = 0; k < tapsPerPhase; ++k)
+				sum += Lane::fromRawArray(taps.data() + k * numLanes + lane) * Lane::fromRawArray(newest - k * numLanes + lane);
+
+			const auto peak = Lane::max(Lane::fromRawArray(peaks.data() + lane), Lane::max(sum, Lane::expand(0.f) - sum));
+			peak.copyToRawArray(peaks.data() + lane);
+		}
+#else
+		for (int lane = 0; lane < numLanes; ++lane)
+		{
+			auto sum = 0.f;
+			for (int k = 0; k < tapsPerPhase; ++k)
+				sum += taps[static_cast<size_t>(k * numLanes + lane)] * newest[lane - k * numLanes];
+
+			peaks[static_cast<size_t>(lane)] = juce::jmax(peaks[static_cast<size_t>(lane)], std::abs(sum));
+		}
+#endif
+	}
+
+	for (int ch = 0; ch < numChannels; ++ch)
+	{
+		const auto* channelPeaks = peaks.data() + ch * phases;
+		truePeak[static_cast<size_t>(ch)].store(*std::max_element(channelPeaks, channelPeaks + phases), std::memory_order_relaxed);
+	}
+}
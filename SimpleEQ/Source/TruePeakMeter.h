@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+	TruePeakMeter.h
+
+	ITU-R BS.1770 true peak of the output: each channel interpolated 4x with
+	a 48 tap windowed-sinc FIR, 12 taps per phase, and the largest magnitude
+	held per channel until reset.
+
+	Each SIMD lane is one phase of one channel, so a register works out four
+	interpolated samples of a channel (or of two channels, on eight lanes) in
+	12 multiply-adds, one per tap. The inputs are kept broadcast across their
+	channel's lanes, twice over, so every tap reads one register straight
+	from memory.
+
+	Most blocks can't raise the peak. No phase gains more than the sum of its
+	taps' magnitudes, so a block whose sample peak times that bound stays
+	under the peak held so far is only pushed into the history, not filtered.
+
+	process() is for the audio thread; the readings can be read from any thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+class TruePeakMeter
+{
+public:
+	static constexpr int maxChannels = 2;
+	static constexpr int phases = 4;
+	static constexpr int tapsPerPhase = 12;
+
+	TruePeakMeter();
+
+	void reset() noexcept;
+	void process(const juce::AudioBuffer<float>& buffer) noexcept;
+
+	// The highest true peak since reset, in dBTP
+	float getTruePeakDb(int channel) const noexcept;
+
+	juce::String getReport() const;
+
+private:
+	void pushSample(const std::array<const float*, maxChannels>& channels, int numChannels, int index) noexcept;
+
+	static constexpr int numLanes = maxChannels * phases;
+
+#if JUCE_USE_SIMD
+	using Lane = juce::dsp::SIMDRegister<float>;
+	static constexpr int laneWidth = static_cast<int>(Lane::SIMDNumElements);
+	static_assert(numLanes % laneWidth == 0 && laneWidth % phases == 0, "registers must hold whole channels");
+#endif
+
+	// Rows of numLanes. Lane channel * phases + phase of row k is tap k of that
+	// phase, the same for every channel.
+	alignas(32) std::array<float, tapsPerPhase * numLanes> taps{};
+
+	// Each input broadcast across its channel's lanes, written to row position
+	// and row position + tapsPerPhase so the last tapsPerPhase inputs are
+	// always contiguous
+	alignas(32) std::array<float, 2 * tapsPerPhase * numLanes> history{};
+	int position = 0;
+
+	alignas(32) std::array<float, numLanes> peaks{};
+
+	// The largest gain of any phase, and the largest input still in the history
+	float phaseBound = 1.f;
+	std::array<float, maxChannels> historyPeak{};
+
+	std::array<std::atomic<float>, maxChannels> truePeak;
+};
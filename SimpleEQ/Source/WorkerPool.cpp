@@ -0,0 +1,234 @@
+/*
+  ==============================================================================
+
+	WorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "WorkerPool.h"
+
+#if JUCE_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	int getDefaultNumWorkers()
+	{
+		return juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 4);
+	}
+
+	const char* getTaskTypeName(WorkerPool::TaskType type)
+	{
+		switch (type)
+		{
+			case WorkerPool::TaskType::Preparation:       return "preparation";
+			case WorkerPool::TaskType::Analyzer:          return "analyzer";
+			case WorkerPool::TaskType::ResponseCurve:     return "response curve";
+			case WorkerPool::TaskType::CoefficientDesign: return "coefficient design";
+			case WorkerPool::TaskType::NumTaskTypes:      break;
+		}
+		return "";
+	}
+
+	void lowerCurrentThreadPriority()
+	{
+#if JUCE_LINUX
+		// SCHED_IDLE only runs when a core would otherwise be idle; fall back to
+		// the weakest nice level where the scheduler policy can't be changed
+		sched_param param{};
+		if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0)
+			setpriority(PRIO_PROCESS, 0, 19);
+#endif
+	}
+}
+
+//==============================================================================
+class WorkerPool::Worker : public juce::Thread
+{
+public:
+	Worker(WorkerPool& poolToUse, int index)
+		: juce::Thread("SimpleEQ worker " + juce::String(index)),
+		pool(poolToUse)
+	{
+	}
+
+	void run() override
+	{
+		lowerCurrentThreadPriority();
+
+		QueuedJob job;
+		while (pool.waitForJob(job, runningOwner))
+		{
+			auto mask = pool.affinityMask.load();
+			if (mask != appliedAffinityMask)
+			{
+				setCurrentThreadAffinityMask(mask != 0 ? mask : ~juce::uint32(0));
+				appliedAffinityMask = mask;
+			}
+
+			auto start = juce::Time::getHighResolutionTicks();
+			job.job();
+			auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+
+			job.job = nullptr;
+			pool.finishJob(runningOwner, job.type, static_cast<juce::int64>(elapsed * 1.0e6));
+		}
+	}
+
+	// Guarded by the pool's queueMutex
+	const void* runningOwner = nullptr;
+
+private:
+	WorkerPool& pool;
+	juce::uint32 appliedAffinityMask = 0;
+};
+
+//==============================================================================
+WorkerPool::WorkerPool()
+{
+	const auto numCpus = juce::jlimit(1, 32, juce::SystemStats::getNumCpus());
+	allCores = numCpus == 32 ? ~juce::uint32(0) : (juce::uint32(1) << numCpus) - 1;
+
+	// All of them exist before any starts, the workers read the list
+	for (int i = 0; i < getDefaultNumWorkers(); ++i)
+		workers.push_back(std::make_unique<Worker>(*this, i));
+
+	for (auto& worker : workers)
+		worker->startThread(juce::Thread::Priority::background);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		shuttingDown = true;
+		queue.clear();
+	}
+	queueChanged.notify_all();
+
+	for (auto& worker : workers)
+		worker->stopThread(-1);
+}
+
+void WorkerPool::addJob(const void* owner, TaskType type, Job job)
+{
+	// Idle workers have no owner, a null one would look like it is always running
+	jassert(owner != nullptr);
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		queue.push_back({ owner, type, std::move(job) });
+	}
+	queueChanged.notify_one();
+}
+
+void WorkerPool::cancelJobsFor(const void* owner)
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+
+	queue.erase(std::remove_if(queue.begin(), queue.end(),
+		[owner](const QueuedJob& j) { return j.owner == owner; }),
+		queue.end());
+
+	jobFinished.wait(lock, [this, owner] { return !isRunning(owner); });
+}
+
+bool WorkerPool::isRunning(const void* owner) const
+{
+	return std::any_of(workers.begin(), workers.end(),
+		[owner](const auto& w) { return w->runningOwner == owner; });
+}
+
+std::deque<WorkerPool::QueuedJob>::iterator WorkerPool::findRunnableJob()
+{
+	// The oldest job whose owner has nothing running. Anything queued behind a
+	// running job of the same owner waits for it, which keeps each owner in order.
+	return std::find_if(queue.begin(), queue.end(),
+		[this](const QueuedJob& j) { return !isRunning(j.owner); });
+}
+
+bool WorkerPool::waitForJob(QueuedJob& job, const void*& runningOwnerSlot)
+{
+	std::unique_lock<std::mutex> lock(queueMutex);
+	queueChanged.wait(lock, [this] { return shuttingDown || findRunnableJob() != queue.end(); });
+
+	if (shuttingDown)
+		return false;
+
+	auto next = findRunnableJob();
+	job = std::move(*next);
+	queue.erase(next);
+	runningOwnerSlot = job.owner;
+	return true;
+}
+
+void WorkerPool::finishJob(const void*& runningOwnerSlot, TaskType type, juce::int64 micros)
+{
+	auto& s = stats[static_cast<size_t>(type)];
+	s.count.fetch_add(1);
+	s.totalMicros.fetch_add(micros);
+
+	auto previousMax = s.maxMicros.load();
+	while (micros > previousMax && !s.maxMicros.compare_exchange_weak(previousMax, micros)) {}
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		runningOwnerSlot = nullptr;
+	}
+
+	// The owner's next job may be runnable now, and any cancelJobsFor() waiting on
+	// the owner can return
+	queueChanged.notify_one();
+	jobFinished.notify_all();
+}
+
+void WorkerPool::avoidCurrentCore() noexcept
+{
+#if JUCE_LINUX
+	const auto cpu = sched_getcpu();
+	if (cpu < 0 || cpu >= 32)
+		return;
+
+	const auto core = juce::uint32(1) << cpu;
+	if ((audioCores.load(std::memory_order_relaxed) & core) != 0)
+		return;
+
+	const auto avoided = audioCores.fetch_or(core) | core;
+	const auto allowed = allCores & ~avoided;
+
+	// The workers pick this up before their next job
+	affinityMask.store(allowed != 0 ? allowed : 0);
+#endif
+}
+
+WorkerPool::TaskStats WorkerPool::getStats(TaskType type) const
+{
+	const auto& s = stats[static_cast<size_t>(type)];
+
+	TaskStats result;
+	result.count = s.count.load();
+	result.totalMs = static_cast<double>(s.totalMicros.load()) / 1000.0;
+	result.maxMs = static_cast<double>(s.maxMicros.load()) / 1000.0;
+	return result;
+}
+
+juce::String WorkerPool::getStatsReport() const
+{
+	juce::String report;
+	report << "SimpleEQ worker pool: " << getNumThreads() << " threads" << juce::newLine;
+
+	for (int i = 0; i < static_cast<int>(TaskType::NumTaskTypes); ++i)
+	{
+		auto type = static_cast<TaskType>(i);
+		auto s = getStats(type);
+		report << "  " << getTaskTypeName(type) << ": " << s.count << " jobs, "
+			<< juce::String(s.totalMs, 2) << " ms total, "
+			<< juce::String(s.maxMs, 2) << " ms max" << juce::newLine;
+	}
+
+	return report;
+}
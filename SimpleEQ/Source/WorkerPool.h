@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+	WorkerPool.h
+
+	One small pool of low-priority threads shared by every SimpleEQ instance in
+	the process. Use it through juce::SharedResourcePointer<WorkerPool> for
+	anything that is not realtime: resource builds, analyzer FFTs, response
+	curves and coefficient pre-design. Never call addJob() from the audio thread,
+	it allocates.
+
+	Jobs with the same owner run one at a time and in the order they were added,
+	so a later job never finishes before an earlier one. Different owners run
+	side by side.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+class WorkerPool
+{
+public:
+	enum class TaskType
+	{
+		Preparation,
+		Analyzer,
+		ResponseCurve,
+		CoefficientDesign,
+		NumTaskTypes
+	};
+
+	struct TaskStats
+	{
+		juce::int64 count = 0;
+		double totalMs = 0.0;
+		double maxMs = 0.0;
+	};
+
+	using Job = std::function<void()>;
+
+	WorkerPool();
+	~WorkerPool();
+
+	// owner keys the ordering and cancelJobsFor(), usually the caller's this. Never null.
+	void addJob(const void* owner, TaskType type, Job job);
+
+	// Drops queued jobs for this owner and waits for any that are already running.
+	// Must not be called from inside one of the owner's jobs.
+	void cancelJobsFor(const void* owner);
+
+	// Keeps the workers off the core the calling thread is running on. Call it from
+	// the audio thread, every core audio has been seen on is then avoided, unless
+	// that would leave none. Lock-free. Only Linux reports the current core, so
+	// elsewhere it does nothing and the workers run anywhere.
+	void avoidCurrentCore() noexcept;
+
+	// The cores the workers are restricted to, 0 when they aren't
+	juce::uint32 getAffinityMask() const noexcept { return affinityMask.load(); }
+
+	int getNumThreads() const noexcept { return static_cast<int>(workers.size()); }
+
+	TaskStats getStats(TaskType type) const;
+	juce::String getStatsReport() const;
+
+private:
+	class Worker;
+
+	struct QueuedJob
+	{
+		const void* owner = nullptr;
+		TaskType type = TaskType::Preparation;
+		Job job;
+	};
+
+	struct AtomicStats
+	{
+		std::atomic<juce::int64> count{ 0 };
+		std::atomic<juce::int64> totalMicros{ 0 };
+		std::atomic<juce::int64> maxMicros{ 0 };
+	};
+
+	bool waitForJob(QueuedJob& job, const void*& runningOwnerSlot);
+	void finishJob(const void*& runningOwnerSlot, TaskType type, juce::int64 micros);
+
+	// Called with queueMutex held
+	bool isRunning(const void* owner) const;
+	std::deque<QueuedJob>::iterator findRunnableJob();
+
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;   // workers wait on this for jobs
+	std::condition_variable jobFinished;    // cancelJobsFor() waits on this
+	std::deque<QueuedJob> queue;
+	bool shuttingDown = false;
+
+	juce::uint32 allCores = 0;
+	std::atomic<juce::uint32> audioCores{ 0 };
+	std::atomic<juce::uint32> affinityMask{ 0 };
+	std::array<AtomicStats, static_cast<size_t>(TaskType::NumTaskTypes)> stats;
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WorkerPool)
+};
@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+	PaintBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "PaintBenchmark.h"
+#include "PluginProcessor.h"
+
+namespace
+{
+	const double benchmark_sample_rate = 48000.0;
+	const int benchmark_block_size = 512;
+	const double benchmark_frame_rate = 60.0;
+	const double benchmark_prepare_timeout_ms = 5000.0;
+}
+
+PaintBenchmark::PaintBenchmark(SimpleEQAudioProcessor& processorToUse)
+	: processor(processorToUse)
+{
+}
+
+std::vector<PaintBenchmark::Result> PaintBenchmark::run(const std::vector<juce::Rectangle<int>>& sizes, int framesPerSize)
+{
+	JUCE_ASSERT_MESSAGE_THREAD
+
+	std::vector<Result> results;
+
+	sampleRate = benchmark_sample_rate;
+	processor.setRateAndBufferSizeDetails(sampleRate, benchmark_block_size);
+	processor.prepareToPlay(sampleRate, benchmark_block_size);
+	buffer.setSize(2, benchmark_block_size);
+
+	// The FIFOs and the analyzer are prepared on the worker pool
+	const auto prepareStart = juce::Time::getMillisecondCounterHiRes();
+	while (!processor.preparation.isReady())
+	{
+		if (juce::Time::getMillisecondCounterHiRes() - prepareStart > benchmark_prepare_timeout_ms)
+		{
+			jassertfalse;
+			return results;
+		}
+
+		juce::Thread::sleep(1);
+	}
+
+	std::unique_ptr<juce::AudioProcessorEditor> editor(processor.createEditorAndMakeActive());
+	if (editor == nullptr)
+		return results;
+
+	// The scheduler's monitors can't run while we hold the message thread, so
+	// this sticks until the benchmark returns
+	processor.editorVisible.store(true);
+	processor.updateResponsePlots();
+
+	juce::SharedResourcePointer<FrameScheduler> frameScheduler;
+	const auto samplesPerFrame = juce::roundToInt(sampleRate / benchmark_frame_rate);
+
+	for (const auto& size : sizes)
+	{
+		Result result;
+		result.size = size;
+		result.numFrames = framesPerSize;
+
+		editor->setSize(size.getWidth(), size.getHeight());
+
+		juce::Image image(juce::Image::ARGB, size.getWidth(), size.getHeight(), true, juce::SoftwareImageType());
+
+		for (int frame = 0; frame < framesPerSize; ++frame)
+		{
+			feedAudio(samplesPerFrame);
+			processor.analyzer->analyseNow();
+
+			auto start = juce::Time::getMillisecondCounterHiRes();
+			frameScheduler->tick(true);
+			result.tickMsPerFrame += juce::Time::getMillisecondCounterHiRes() - start;
+
+			{
+				juce::Graphics g(image);
+				start = juce::Time::getMillisecondCounterHiRes();
+				editor->paintEntireComponent(g, true);
+				result.paintMsPerFrame += juce::Time::getMillisecondCounterHiRes() - start;
+			}
+
+			timeComponents(*editor, result.msPerFrameByKind);
+		}
+
+		result.tickMsPerFrame /= framesPerSize;
+		result.paintMsPerFrame /= framesPerSize;
+		for (auto& kind : result.msPerFrameByKind)
+			kind.second /= framesPerSize;
+
+		results.push_back(std::move(result));
+	}
+
+	editor.reset();
+	processor.editorVisible.store(false);
+	processor.releaseResources();
+
+	return results;
+}
+
+void PaintBenchmark::feedAudio(int numSamples)
+{
+	// A slow sine sweep over pink-ish noise keeps every part of the spectrum
+	// and the spectrogram changing from frame to frame
+	const auto twoPi = juce::MathConstants<double>::twoPi;
+
+	for (int done = 0; done < numSamples; done += benchmark_block_size)
+	{
+		const auto blockSize = juce::jmin(benchmark_block_size, numSamples - done);
+		buffer.setSize(2, blockSize, false, false, true);
+
+		auto* left = buffer.getWritePointer(0);
+		auto* right = buffer.getWritePointer(1);
+
+		for (int i = 0; i < blockSize; ++i)
+		{
+			const auto sweep = 0.5 + 0.5 * std::sin(phase * 0.0001);
+			phase += twoPi * (40.0 + 8000.0 * sweep * sweep) / sampleRate;
+
+			noiseState += 0.1f * (random.nextFloat() * 2.f - 1.f - noiseState);
+			const auto tone = 0.25f * static_cast<float>(std::sin(phase));
+
+			left[i] = tone + 0.2f * noiseState;
+			right[i] = tone + 0.05f * (random.nextFloat() * 2.f - 1.f);
+		}
+
+		processor.processBlock(buffer, midi);
+	}
+}
+
+void PaintBenchmark::timeComponents(juce::Component& parent, std::map<juce::String, double>& msByKind)
+{
+	for (auto* child : parent.getChildren())
+	{
+		if (!child->isVisible() || child->getWidth() <= 0 || child->getHeight() <= 0)
+			continue;
+
+		const auto kind = getKind(*child);
+		if (kind.isEmpty())
+		{
+			timeComponents(*child, msByKind);
+			continue;
+		}
+
+		juce::Image image(juce::Image::ARGB, child->getWidth(), child->getHeight(), true, juce::SoftwareImageType());
+		juce::Graphics g(image);
+
+		const auto start = juce::Time::getMillisecondCounterHiRes();
+		child->paintEntireComponent(g, true);
+		msByKind[kind] += juce::Time::getMillisecondCounterHiRes() - start;
+	}
+}
+
+juce::String PaintBenchmark::getKind(juce::Component& component)
+{
+	if (auto* plot = dynamic_cast<CurvePlotComponent*>(&component))
+	{
+		if (dynamic_cast<SpectrumAnalyser*>(plot->getSource()) != nullptr)
+			return "analyzer plot";
+
+		return "response plots";
+	}
+
+	if (dynamic_cast<SpectrogramComponent*>(&component) != nullptr)
+		return "spectrogram";
+
+	if (dynamic_cast<juce::Slider*>(&component) != nullptr)
+		return "sliders";
+
+	if (dynamic_cast<juce::ComboBox*>(&component) != nullptr
+		|| dynamic_cast<juce::Button*>(&component) != nullptr
+		|| dynamic_cast<juce::Label*>(&component) != nullptr)
+		return "other controls";
+
+	// Containers are descended into, only their children are timed
+	return {};
+}
+
+juce::String PaintBenchmark::createReport(const std::vector<Result>& results)
+{
+	juce::String report;
+	report << "SimpleEQ paint benchmark (software renderer)" << juce::newLine;
+
+	for (const auto& result : results)
+	{
+		report << "  " << result.size.getWidth() << "x" << result.size.getHeight()
+			<< ", " << result.numFrames << " frames: "
+			<< juce::String(result.paintMsPerFrame, 3) << " ms paint, "
+			<< juce::String(result.tickMsPerFrame, 3) << " ms update per frame" << juce::newLine;
+
+		for (const auto& kind : result.msPerFrameByKind)
+			report << "    " << kind.first << ": " << juce::String(kind.second, 3) << " ms" << juce::newLine;
+	}
+
+	return report;
+}
+
+//==============================================================================
+class PaintBenchmarkTest : public juce::UnitTest
+{
+public:
+	PaintBenchmarkTest() : juce::UnitTest("Editor paint", "Editor") {}
+
+	void runTest() override
+	{
+		beginTest("Renders every size");
+
+		SimpleEQAudioProcessor processor;
+		PaintBenchmark benchmark(processor);
+
+		const std::vector<juce::Rectangle<int>> sizes{ { 0, 0, 650, 350 }, { 0, 0, 1300, 700 } };
+		constexpr int framesPerSize = 30;
+		const auto results = benchmark.run(sizes, framesPerSize);
+
+		// Empty if the preparation timed out or no editor was made
+		expectEquals(static_cast<int>(results.size()), static_cast<int>(sizes.size()), "sizes rendered");
+
+		for (const auto& result : results)
+		{
+			expectEquals(result.numFrames, framesPerSize, "frames rendered");
+			expectGreaterThan(result.paintMsPerFrame, 0.0, "paint time");
+			expect(!result.msPerFrameByKind.empty(), "no component was timed");
+		}
+
+		logMessage(PaintBenchmark::createReport(results));
+	}
+};
+
+static PaintBenchmarkTest paintBenchmarkTest;
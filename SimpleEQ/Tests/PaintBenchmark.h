@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+	PaintBenchmark.h
+
+	Renders the editor built from SimpleEQPeaksSeparate.xml into a software
+	image at a few sizes while synthetic audio keeps the analyzer busy, and
+	reports the time per frame split by the kind of component doing the work.
+	Nothing is put on screen, so SimpleEQTests runs it headless from the
+	message thread and logs the report.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <vector>
+
+class SimpleEQAudioProcessor;
+
+class PaintBenchmark
+{
+public:
+	struct Result
+	{
+		juce::Rectangle<int> size;
+		int numFrames = 0;
+		double tickMsPerFrame = 0.0;             // curve rebuilds and spectrogram columns
+		double paintMsPerFrame = 0.0;            // the whole editor in one pass
+		std::map<juce::String, double> msPerFrameByKind;
+	};
+
+	explicit PaintBenchmark(SimpleEQAudioProcessor& processorToUse);
+
+	// Message thread only. Prepares the processor, so don't run it on an
+	// instance a host is playing through.
+	std::vector<Result> run(const std::vector<juce::Rectangle<int>>& sizes, int framesPerSize = 120);
+	std::vector<Result> run() { return run({ { 0, 0, 650, 350 }, { 0, 0, 1300, 700 }, { 0, 0, 2560, 1440 } }); }
+
+	static juce::String createReport(const std::vector<Result>& results);
+
+private:
+	void feedAudio(int numSamples);
+	void timeComponents(juce::Component& parent, std::map<juce::String, double>& msByKind);
+	static juce::String getKind(juce::Component& component);
+
+	SimpleEQAudioProcessor& processor;
+
+	juce::AudioBuffer<float> buffer;
+	juce::MidiBuffer midi;
+	juce::Random random{ 1234 };
+	double phase = 0.0;
+	float noiseState = 0.f;
+	double sampleRate = 48000.0;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PaintBenchmark)
+};
@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+	ProcessorTests.cpp
+
+	Checks on the processor as a host drives it: what prepareToPlay sets up
+	and what it costs. Each test makes its own instance on the message thread.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+namespace
+{
+	const double prepare_timeout_ms = 5000.0;
+
+	// Prepares like a host would and waits for the background half of it
+	bool prepareAndWait(SimpleEQAudioProcessor& processor, double sampleRate, int samplesPerBlock)
+	{
+		processor.setRateAndBufferSizeDetails(sampleRate, samplesPerBlock);
+		processor.prepareToPlay(sampleRate, samplesPerBlock);
+
+		const auto start = juce::Time::getMillisecondCounterHiRes();
+		while (!processor.isAnalyzerReady())
+		{
+			if (juce::Time::getMillisecondCounterHiRes() - start > prepare_timeout_ms)
+				return false;
+
+			juce::Thread::sleep(1);
+		}
+
+		return true;
+	}
+}
+
+//==============================================================================
+class AnalyzerMemoryTest : public juce::UnitTest
+{
+public:
+	AnalyzerMemoryTest() : juce::UnitTest("Analyzer memory", "Processor") {}
+
+	void runTest() override
+	{
+		SimpleEQAudioProcessor processor;
+
+		beginTest("Independent of the host block size");
+		{
+			expect(prepareAndWait(processor, 48000.0, 512), "preparation timed out");
+			const auto reference = processor.getAnalyzerMemoryUsageInBytes();
+			logMessage("  " + juce::File::descriptionOfSizeInBytes(static_cast<juce::int64>(reference)) + " at 48 kHz");
+
+			for (auto samplesPerBlock : { 32, 4096, 16384 })
+			{
+				expect(prepareAndWait(processor, 48000.0, samplesPerBlock), "preparation timed out");
+				expectEquals(processor.getAnalyzerMemoryUsageInBytes(), reference,
+					juce::String(samplesPerBlock) + " sample blocks");
+			}
+		}
+
+		beginTest("Follows the sample rate");
+		{
+			expect(prepareAndWait(processor, 48000.0, 512), "preparation timed out");
+			const auto at48k = static_cast<double>(processor.getAnalyzerMemoryUsageInBytes());
+			expect(prepareAndWait(processor, 192000.0, 512), "preparation timed out");
+			const auto at192k = static_cast<double>(processor.getAnalyzerMemoryUsageInBytes());
+
+			// The FIFOs hold a fixed time, rounded up to whole slots
+			expectGreaterThan(at192k, 3.0 * at48k, "FIFOs didn't grow with the rate");
+			expectLessThan(at192k, 5.0 * at48k, "FIFOs grew faster than the rate");
+		}
+
+		processor.releaseResources();
+	}
+};
+
+static AnalyzerMemoryTest analyzerMemoryTest;
+
+//==============================================================================
+class InstanceReadyTest : public juce::UnitTest
+{
+public:
+	InstanceReadyTest() : juce::UnitTest("Instance ready time", "Processor") {}
+
+	void runTest() override
+	{
+		SimpleEQAudioProcessor processor;
+
+		beginTest("prepareToPlay returns before the analyzer is built");
+		for (auto sampleRate : { 44100.0, 48000.0, 96000.0, 192000.0 })
+		{
+			const auto start = juce::Time::getMillisecondCounterHiRes();
+			expect(prepareAndWait(processor, sampleRate, 512), "preparation timed out");
+			const auto waitedMs = juce::Time::getMillisecondCounterHiRes() - start;
+			const auto readyMs = processor.getLastInstanceReadyTimeMs();
+
+			logMessage("  " + juce::String(sampleRate / 1000.0, 1) + " kHz ready after " + juce::String(readyMs, 2) + " ms");
+
+			// Measured from inside prepareToPlay, so it can't exceed the wait around it
+			expectGreaterThan(readyMs, 0.0, "no ready time recorded");
+			expectLessOrEqual(readyMs, waitedMs, "ready time longer than the wait");
+
+			// It sizes buffers and sets up the analyzer, so this catches a build that stalls, not a slow machine
+			expectLessThan(readyMs, 1000.0, "analyzer took too long to build");
+		}
+
+		processor.releaseResources();
+	}
+};
+
+static InstanceReadyTest instanceReadyTest;
@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+	TestMain.cpp
+
+	Runs every juce::UnitTest linked into SimpleEQTests and exits non-zero if
+	any expectation failed. Pass a number to reseed the random settings.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+int main(int argc, char* argv[])
+{
+	// Anything that builds a processor or an editor needs a message manager
+	juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+	// The same as on the audio thread, denormals would only distort the timings
+	juce::ScopedNoDenormals noDenormals;
+
+	const auto seed = argc > 1 ? juce::String(argv[1]).getLargeIntValue() : juce::int64(0x51e0);
+
+	juce::UnitTestRunner runner;
+	runner.setAssertOnFailure(false);
+	runner.runAllTests(seed);
+
+	int numFailures = 0;
+	for (int i = 0; i < runner.getNumResults(); ++i)
+		numFailures += runner.getResult(i)->failures;
+
+	return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+	WorkerPoolTests.cpp
+
+	Ordering, cancellation, shutdown and cost accounting of the worker pool.
+	Each test makes its own pool rather than the shared one, so nothing it
+	queues or measures leaks into the other tests.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <thread>
+#include "WorkerPool.h"
+
+namespace
+{
+	const int job_timeout_ms = 5000;
+}
+
+//==============================================================================
+class WorkerPoolTest : public juce::UnitTest
+{
+public:
+	WorkerPoolTest() : juce::UnitTest("Worker pool", "Concurrency") {}
+
+	void runTest() override
+	{
+		beginTest("Runs an owner's jobs one at a time, in order");
+		{
+			WorkerPool pool;
+			constexpr int numJobs = 64;
+			int owner = 0;
+
+			std::vector<int> order;
+			std::atomic<int> running{ 0 }, maxRunning{ 0 };
+			juce::WaitableEvent done;
+
+			for (int i = 0; i < numJobs; ++i)
+			{
+				pool.addJob(&owner, WorkerPool::TaskType::CoefficientDesign, [&, i]
+				{
+					const auto nowRunning = ++running;
+					maxRunning.store(juce::jmax(maxRunning.load(), nowRunning));
+
+					// Unguarded on purpose, two jobs of one owner never overlap
+					order.push_back(i);
+					juce::Thread::sleep(i % 3);
+
+					--running;
+					if (i == numJobs - 1)
+						done.signal();
+				});
+			}
+
+			expect(done.wait(job_timeout_ms), "jobs didn't finish");
+			pool.cancelJobsFor(&owner);
+
+			expectEquals(maxRunning.load(), 1, "an owner's jobs overlapped");
+			expectEquals(static_cast<int>(order.size()), numJobs, "jobs run");
+			expect(std::is_sorted(order.begin(), order.end()), "jobs ran out of order");
+		}
+
+		beginTest("Different owners run side by side");
+		if (WorkerPool pool; pool.getNumThreads() > 1)
+		{
+			int first = 0, second = 0;
+			juce::WaitableEvent firstStarted;
+			juce::WaitableEvent secondRan{ true };  // both the first job and the test wait on it
+
+			pool.addJob(&first, WorkerPool::TaskType::Analyzer, [&]
+			{
+				firstStarted.signal();
+				secondRan.wait(job_timeout_ms);
+			});
+			pool.addJob(&second, WorkerPool::TaskType::Analyzer, [&] { secondRan.signal(); });
+
+			expect(firstStarted.wait(job_timeout_ms), "first job didn't start");
+			expect(secondRan.wait(job_timeout_ms), "second owner waited for the first");
+			pool.cancelJobsFor(&first);
+			pool.cancelJobsFor(&second);
+		}
+
+		beginTest("Cancel drops queued jobs and waits for the running one");
+		{
+			WorkerPool pool;
+			int owner = 0;
+
+			juce::WaitableEvent started;
+			std::atomic<bool> finished{ false };
+			std::atomic<int> numQueuedRun{ 0 };
+
+			pool.addJob(&owner, WorkerPool::TaskType::Preparation, [&]
+			{
+				started.signal();
+				juce::Thread::sleep(50);
+				finished.store(true);
+			});
+
+			for (int i = 0; i < 10; ++i)
+				pool.addJob(&owner, WorkerPool::TaskType::Preparation, [&] { ++numQueuedRun; });
+
+			expect(started.wait(job_timeout_ms), "job didn't start");
+			pool.cancelJobsFor(&owner);
+
+			expect(finished.load(), "cancel returned while the job was running");
+			expectEquals(numQueuedRun.load(), 0, "queued jobs ran after the cancel");
+		}
+
+		beginTest("A waiting cancel doesn't hold up new jobs");
+		if (WorkerPool pool; pool.getNumThreads() > 1)
+		{
+			int slow = 0, quick = 0;
+			juce::WaitableEvent slowStarted;
+			juce::WaitableEvent quickRan{ true };
+			std::atomic<bool> quickRanFirst{ false };
+
+			// Runs until the quick job has, so a stall shows up as a timeout here
+			pool.addJob(&slow, WorkerPool::TaskType::Preparation, [&]
+			{
+				slowStarted.signal();
+				quickRanFirst.store(quickRan.wait(job_timeout_ms));
+			});
+			expect(slowStarted.wait(job_timeout_ms), "job didn't start");
+
+			std::thread canceller([&pool, &slow] { pool.cancelJobsFor(&slow); });
+			juce::Thread::sleep(10);
+			pool.addJob(&quick, WorkerPool::TaskType::Analyzer, [&] { quickRan.signal(); });
+
+			canceller.join();
+			pool.cancelJobsFor(&quick);
+			expect(quickRanFirst.load(), "new job stalled behind a cancel");
+		}
+
+		beginTest("Shutdown finishes the running job and drops the rest");
+		{
+			int owner = 0;
+			juce::WaitableEvent started;
+			std::atomic<bool> finished{ false };
+			std::atomic<int> numQueuedRun{ 0 };
+
+			auto pool = std::make_unique<WorkerPool>();
+			pool->addJob(&owner, WorkerPool::TaskType::Preparation, [&]
+			{
+				started.signal();
+				juce::Thread::sleep(50);
+				finished.store(true);
+			});
+
+			for (int i = 0; i < 100; ++i)
+				pool->addJob(&owner, WorkerPool::TaskType::Preparation, [&] { ++numQueuedRun; });
+
+			expect(started.wait(job_timeout_ms), "job didn't start");
+			pool.reset();
+
+			expect(finished.load(), "the pool went before its running job");
+			expectEquals(numQueuedRun.load(), 0, "queued jobs ran during shutdown");
+		}
+
+		beginTest("Accounts the time per task type");
+		{
+			WorkerPool pool;
+			int owner = 0;
+			constexpr int numJobs = 5;
+			constexpr int jobMs = 4;
+			juce::WaitableEvent done;
+
+			for (int i = 0; i < numJobs; ++i)
+			{
+				pool.addJob(&owner, WorkerPool::TaskType::ResponseCurve, [&done, i]
+				{
+					juce::Thread::sleep(jobMs);
+					if (i == numJobs - 1)
+						done.signal();
+				});
+			}
+
+			expect(done.wait(job_timeout_ms), "jobs didn't finish");
+
+			// The last job is counted after it returns
+			pool.cancelJobsFor(&owner);
+
+			const auto stats = pool.getStats(WorkerPool::TaskType::ResponseCurve);
+			expectEquals(static_cast<int>(stats.count), numJobs, "jobs counted");
+			expectGreaterOrEqual(stats.maxMs, jobMs * 0.9, "longest job");
+			expectGreaterOrEqual(stats.totalMs, numJobs * jobMs * 0.9, "total time");
+			expectLessOrEqual(stats.maxMs, stats.totalMs, "longest job against the total");
+			expectEquals(static_cast<int>(pool.getStats(WorkerPool::TaskType::Analyzer).count), 0, "other types counted");
+
+			const auto report = pool.getStatsReport();
+			expect(report.contains("response curve: " + juce::String(numJobs) + " jobs"), "report: " + report);
+			logMessage(report.trimEnd());
+		}
+
+		beginTest("Keeps off the cores audio runs on");
+		{
+			WorkerPool pool;
+			pool.avoidCurrentCore();
+			const auto mask = pool.getAffinityMask();
+
+#if JUCE_LINUX
+			// The test thread may have moved since, so only the count is certain. The
+			// mask covers the first 32 cores, beyond them nothing changes.
+			const auto numCpus = juce::SystemStats::getNumCpus();
+			if (numCpus == 1)
+				expectEquals(static_cast<int>(mask), 0, "restricted with nowhere else to run");
+			else if (numCpus <= 32)
+				expectEquals(juce::countNumberOfBits(mask), numCpus - 1, "cores left to the workers");
+#else
+			expectEquals(static_cast<int>(mask), 0, "restricted without knowing the audio core");
+#endif
+		}
+	}
+};
+
+static WorkerPoolTest workerPoolTest;